@@ -0,0 +1,204 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <cmath>
+
+#include "animation.hpp"
+
+std::optional<AnimationSet::ClipId> AnimationSet::find(const std::string& name) const
+{
+    for(std::size_t i = 0; i < m_clips.size(); i++)
+        if ( m_clips[i].name == name )
+            return static_cast<ClipId>(i);
+    return std::nullopt;
+}
+
+std::optional<AnimationSet> loadAnimationSet(const std::filesystem::path& path)
+{
+    std::ifstream in(path);
+    if ( !in )
+    {
+        std::cerr << "Unable to open animation " << path << std::endl;
+        return std::nullopt;
+    }
+
+    std::vector<AnimationSet::Clip> clips;
+    std::vector<AnimationSet::Frame> frames;
+    std::string line;
+    for(int lineNumber = 1; std::getline(in, line); lineNumber++)
+    {
+        std::istringstream fields(line);
+        std::string keyword;
+        if ( !(fields >> keyword) || '#' == keyword[0] )
+            continue;
+
+        bool valid = false;
+        if ( "clip" == keyword )
+        {
+            std::string name, mode;
+            valid = (fields >> name >> mode) && ("loop" == mode || "once" == mode);
+            if ( valid )
+                clips.push_back({name, static_cast<std::uint32_t>(frames.size()), 0, 0.0f, "loop" == mode});
+        }
+        else if ( "frame" == keyword && !clips.empty() )
+        {
+            SDL_Rect rect;
+            float milliseconds = 0;
+            valid = (fields >> rect.x >> rect.y >> rect.w >> rect.h >> milliseconds) && milliseconds > 0
+                && rect.x >= 0 && rect.y >= 0 && rect.w > 0 && rect.h > 0;
+            if ( valid )
+            {
+                AnimationSet::Clip& clip = clips.back();
+                clip.duration += milliseconds / 1000.0f;
+                clip.count++;
+                frames.push_back({rect, clip.duration});
+            }
+        }
+
+        if ( !valid )
+        {
+            std::cerr << path.string() << ":" << lineNumber << ": expected 'clip NAME loop|once' or 'frame X Y W H MS', got '"
+                      << line << "'" << std::endl;
+            return std::nullopt;
+        }
+    }
+
+    for(const AnimationSet::Clip& clip : clips)
+    {
+        if ( 0 == clip.count )
+        {
+            std::cerr << "Clip " << clip.name << " in " << path << " has no frames" << std::endl;
+            return std::nullopt;
+        }
+    }
+    return AnimationSet(std::move(clips), std::move(frames));
+}
+
+SpriteAnimator::SheetId SpriteAnimator::addSheet(const AnimationSet& set, TextureRegion region)
+{
+    SDL_Texture* texture = region.texture();
+    int pageW = 1, pageH = 1;
+    SDL_QueryTexture( texture, NULL, NULL, &pageW, &pageH );
+
+    // sheets on the same texture are drawn together
+    std::uint32_t batch = 0;
+    while ( batch < m_batches.size() && m_batches[batch].texture != texture )
+        batch++;
+    if ( batch == m_batches.size() )
+        m_batches.push_back({texture, {}});
+
+    const SDL_Rect& r = region.rect();
+    const auto firstFrame = static_cast<std::uint32_t>(m_frames.size());
+    for(const AnimationSet::Frame& frame : set.frames())
+    {
+        if ( frame.rect.x + frame.rect.w > r.w || frame.rect.y + frame.rect.h > r.h )
+            std::cerr << "Animation frame at " << frame.rect.x << "," << frame.rect.y << " reaches past its "
+                      << r.w << "x" << r.h << " sheet" << std::endl;
+
+        const float x = static_cast<float>(r.x + frame.rect.x);
+        const float y = static_cast<float>(r.y + frame.rect.y);
+        m_frames.push_back({frame.end, x / pageW, y / pageH, (x + frame.rect.w) / pageW, (y + frame.rect.h) / pageH, batch});
+    }
+
+    const auto firstClip = static_cast<std::uint32_t>(m_clips.size());
+    m_sheetFirstClip.push_back(firstClip);
+    for(const AnimationSet::Clip& clip : set.clips())
+        m_clips.push_back({firstFrame + clip.first, firstFrame + clip.first + clip.count - 1, clip.duration, clip.loop, firstClip});
+
+    return static_cast<SheetId>(m_sheetFirstClip.size() - 1);
+}
+
+SpriteAnimator::Instance SpriteAnimator::add(SheetId sheet, AnimationSet::ClipId clip, const SDL_FRect& dst, float speed, float time)
+{
+    const std::uint32_t id = m_sheetFirstClip.at(sheet) + clip;
+    m_clip.push_back(id);
+    m_frame.push_back(m_clips.at(id).first);
+    m_time.push_back(time);
+    m_speed.push_back(speed);
+    m_dst.push_back(dst);
+    return static_cast<Instance>(m_clip.size() - 1);
+}
+
+void SpriteAnimator::play(Instance instance, AnimationSet::ClipId clip)
+{
+    // clip ids are relative to the sheet of the instance's current clip
+    const std::uint32_t id = m_clips[m_clip[instance]].sheetFirstClip + clip;
+    if ( id == m_clip[instance] )
+        return;
+    m_clip[instance] = id;
+    m_frame[instance] = m_clips.at(id).first;
+    m_time[instance] = 0;
+}
+
+bool SpriteAnimator::finished(Instance instance) const
+{
+    const Clip& clip = m_clips[m_clip[instance]];
+    return !clip.loop && m_time[instance] >= clip.duration;
+}
+
+void SpriteAnimator::update(float seconds)
+{
+    const Clip* clips = m_clips.data();
+    const Frame* frames = m_frames.data();
+    const std::size_t n = m_clip.size();
+    for(std::size_t i = 0; i < n; i++)
+    {
+        const Clip& clip = clips[m_clip[i]];
+        float t = m_time[i] + seconds * m_speed[i];
+        if ( t >= clip.duration )
+            t = clip.loop ? std::fmod(t, clip.duration) : clip.duration;
+        m_time[i] = t;
+
+        // clips are a handful of frames, a scan beats a binary search
+        std::uint32_t f = clip.first;
+        while ( f < clip.last && t >= frames[f].end )
+            f++;
+        m_frame[i] = f;
+    }
+}
+
+void SpriteAnimator::render(Context& ctx)
+{
+    for(Batch& batch : m_batches)
+        batch.vertices.clear();
+
+    const SDL_Color white{0xFF, 0xFF, 0xFF, 0xFF};
+    const std::size_t n = m_clip.size();
+    for(std::size_t i = 0; i < n; i++)
+    {
+        const Frame& f = m_frames[m_frame[i]];
+        const SDL_FRect& d = m_dst[i];
+        auto& vertices = m_batches[f.batch].vertices;
+        vertices.push_back({{d.x, d.y}, white, {f.u0, f.v0}});
+        vertices.push_back({{d.x + d.w, d.y}, white, {f.u1, f.v0}});
+        vertices.push_back({{d.x + d.w, d.y + d.h}, white, {f.u1, f.v1}});
+        vertices.push_back({{d.x, d.y + d.h}, white, {f.u0, f.v1}});
+    }
+
+    m_drawCalls = 0;
+    for(const Batch& batch : m_batches)
+    {
+        const std::size_t quads = batch.vertices.size() / 4;
+        if ( 0 == quads )
+            continue;
+
+        for(auto q = static_cast<int>(m_indices.size() / 6); q < static_cast<int>(quads); q++)
+        {
+            const int v = q * 4;
+            m_indices.insert(m_indices.end(), {v, v + 1, v + 2, v, v + 2, v + 3});
+        }
+
+        SDL_RenderGeometry( ctx.renderer(), batch.texture, batch.vertices.data(), static_cast<int>(batch.vertices.size()),
+            m_indices.data(), static_cast<int>(quads * 6) );
+        m_drawCalls++;
+    }
+}
+
+void SpriteAnimator::clear()
+{
+    m_clip.clear();
+    m_frame.clear();
+    m_time.clear();
+    m_speed.clear();
+    m_dst.clear();
+}
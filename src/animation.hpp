@@ -0,0 +1,124 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <SDL.h>
+
+#include "atlas.hpp"
+#include "context.hpp"
+
+// Clips of one sprite sheet, read from a small text file:
+//   # comment
+//   clip walk loop          (or once: the clip stops on its last frame)
+//   frame X Y W H MS        (rect relative to the sheet, shown for MS milliseconds)
+// Frames belong to the clip line above them.
+class AnimationSet
+{
+public:
+    using ClipId = std::uint32_t;
+
+    struct Frame
+    {
+        SDL_Rect rect;
+        float end;  // seconds after the clip started at which this frame is over
+    };
+
+    struct Clip
+    {
+        std::string name;
+        std::uint32_t first;
+        std::uint32_t count;
+        float duration;
+        bool loop;
+    };
+
+    AnimationSet(std::vector<Clip>&& clips, std::vector<Frame>&& frames):
+        m_clips(std::move(clips)), m_frames(std::move(frames)) {}
+
+    std::optional<ClipId> find(const std::string& name) const;
+
+    const Clip& clip(ClipId id) const {return m_clips.at(id);}
+    const std::vector<Clip>& clips() const noexcept {return m_clips;}
+    const std::vector<Frame>& frames() const noexcept {return m_frames;}
+
+private:
+    std::vector<Clip> m_clips;
+    std::vector<Frame> m_frames;
+};
+
+std::optional<AnimationSet> loadAnimationSet(const std::filesystem::path& path);
+
+// Animated sprite instances for any number of sheets.
+// update() advances all of them by time in one pass over flat arrays; render() draws every instance
+// whose sheet sits on the same texture (e.g. the same atlas page) with a single SDL_RenderGeometry call.
+class SpriteAnimator
+{
+public:
+    using SheetId = std::uint32_t;
+    using Instance = std::uint32_t;
+
+    // region is where the sheet's image is, e.g. in an atlas; its texture must outlive the animator
+    SheetId addSheet(const AnimationSet& set, TextureRegion region);
+
+    // Clip ids are the ones of the set the sheet was added with
+    Instance add(SheetId sheet, AnimationSet::ClipId clip, const SDL_FRect& dst, float speed = 1.0f, float time = 0.0f);
+
+    // Switches clips; the new one starts over unless it is the one already playing
+    void play(Instance instance, AnimationSet::ClipId clip);
+    void setDestination(Instance instance, const SDL_FRect& dst) {m_dst[instance] = dst;}
+    void setSpeed(Instance instance, float speed) {m_speed[instance] = speed;}
+    // True once a clip that doesn't loop has shown its last frame for its full duration
+    bool finished(Instance instance) const;
+
+    void update(float seconds);
+    void render(Context& ctx);
+
+    void clear();
+    std::size_t size() const noexcept {return m_clip.size();}
+    // Number of SDL draw submissions made by the last render()
+    std::size_t drawCalls() const noexcept {return m_drawCalls;}
+
+private:
+    struct Clip
+    {
+        std::uint32_t first;
+        std::uint32_t last;
+        float duration;
+        bool loop;
+        std::uint32_t sheetFirstClip;
+    };
+
+    struct Frame
+    {
+        float end;
+        float u0, v0, u1, v1;
+        std::uint32_t batch;
+    };
+
+    struct Batch
+    {
+        SDL_Texture* texture;
+        std::vector<SDL_Vertex> vertices;
+    };
+
+    // Clips and frames of all sheets, sheets only remember where theirs start
+    std::vector<Clip> m_clips;
+    std::vector<Frame> m_frames;
+    std::vector<std::uint32_t> m_sheetFirstClip;
+    std::vector<Batch> m_batches;
+    std::vector<int> m_indices;  // two triangles per quad, shared by all batches
+
+    // per instance
+    std::vector<std::uint32_t> m_clip;
+    std::vector<std::uint32_t> m_frame;
+    std::vector<float> m_time;
+    std::vector<float> m_speed;
+    std::vector<SDL_FRect> m_dst;
+
+    std::size_t m_drawCalls{0};
+};
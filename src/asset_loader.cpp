@@ -0,0 +1,211 @@
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+
+#include "asset_loader.hpp"
+#include "asset_pack.hpp"
+#include "sound_bank.hpp"
+
+namespace
+{
+    using clock = std::chrono::steady_clock;
+
+    double millisecondsSince(clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(clock::now() - start).count();
+    }
+
+    const char* kindName(AssetLoader::Kind kind)
+    {
+        switch (kind)
+        {
+            case AssetLoader::Kind::Texture: return "texture";
+            case AssetLoader::Kind::Image: return "image";
+            case AssetLoader::Kind::Font: return "font";
+            case AssetLoader::Kind::Music: return "music";
+            case AssetLoader::Kind::Chunk: return "chunk";
+        }
+        return "?";
+    }
+
+    AssetPack::Kind packKind(AssetLoader::Kind kind)
+    {
+        switch (kind)
+        {
+            case AssetLoader::Kind::Chunk: return AssetPack::Kind::Pcm;
+            case AssetLoader::Kind::Font:
+            case AssetLoader::Kind::Music: return AssetPack::Kind::Raw;
+            default: return AssetPack::Kind::Pixels;
+        }
+    }
+}
+
+AssetLoader::AssetLoader(JobSystem& jobs, AssetCache& assets): m_jobs(jobs), m_assets(assets)
+{
+}
+
+AssetLoader::~AssetLoader()
+{
+    m_jobs.wait(m_counter);
+}
+
+void AssetLoader::texture(const std::filesystem::path& path)
+{
+    submit(Kind::Texture, path);
+}
+
+void AssetLoader::image(const std::filesystem::path& path)
+{
+    submit(Kind::Image, path);
+}
+
+void AssetLoader::font(const std::filesystem::path& path, int pointSize)
+{
+    submit(Kind::Font, path, pointSize);
+}
+
+void AssetLoader::music(const std::filesystem::path& path)
+{
+    submit(Kind::Music, path);
+}
+
+void AssetLoader::chunk(const std::filesystem::path& path)
+{
+    submit(Kind::Chunk, path);
+}
+
+void AssetLoader::submit(Kind kind, const std::filesystem::path& path, int pointSize)
+{
+    // nothing to decode, the cache creates packed assets straight from the mapping
+    if ( m_assets.pack() && m_assets.pack()->contains(path, packKind(kind)) )
+        return;
+    if ( Kind::Chunk == kind && m_assets.soundBank() && m_assets.soundBank()->contains(path) )
+        return;
+
+    if ( !m_started )
+    {
+        m_start = clock::now();
+        m_started = true;
+    }
+
+    m_requests.push_back(std::make_unique<Request>());
+    Request* request = m_requests.back().get();
+    request->kind = kind;
+    request->path = path;
+    request->pointSize = pointSize;
+
+    const std::size_t index = m_requests.size() - 1;
+    m_jobs.submit([this, request, index]() {
+        decode(*request);
+        {
+            std::lock_guard lock(m_doneMutex);
+            m_done.push_back(index);
+        }
+        m_doneSignal.notify_one();
+    }, &m_counter);
+}
+
+void AssetLoader::decode(Request& request)
+{
+    const auto start = clock::now();
+    switch (request.kind)
+    {
+        case Kind::Texture:
+        case Kind::Image:
+            request.surface = loadImage(request.path);
+            break;
+        case Kind::Font:
+            request.font = loadFont(request.path, request.pointSize);
+            break;
+        case Kind::Music:
+            request.music = loadMusic(request.path);
+            break;
+        case Kind::Chunk:
+            request.chunk = loadChunk(request.path);
+            break;
+    }
+    request.decodeMs = millisecondsSince(start);
+}
+
+bool AssetLoader::store(Context& ctx, Request& request)
+{
+    Timing timing{request.kind, request.path, request.decodeMs, 0, false};
+
+    switch (request.kind)
+    {
+        case Kind::Texture:
+        {
+            if ( !request.surface )
+                break;
+            const auto start = clock::now();
+            SDL_Texture* texture = SDL_CreateTextureFromSurface( ctx.renderer(), request.surface.get() );
+            timing.uploadMs = millisecondsSince(start);
+            if ( NULL == texture )
+            {
+                std::cerr << "Unable to create texture from " << request.path << "! SDL_error: " << SDL_GetError() << std::endl;
+                break;
+            }
+            timing.loaded = nullptr != m_assets.insert(request.path, Texture(texture, request.surface->w, request.surface->h));
+            request.surface.reset();
+            break;
+        }
+        case Kind::Image:
+            timing.loaded = nullptr != m_assets.insert(request.path, std::move(request.surface));
+            break;
+        case Kind::Font:
+            timing.loaded = nullptr != m_assets.insert(request.path, request.pointSize, std::move(request.font));
+            break;
+        case Kind::Music:
+            timing.loaded = nullptr != m_assets.insert(request.path, std::move(request.music));
+            break;
+        case Kind::Chunk:
+            timing.loaded = nullptr != m_assets.insert(request.path, std::move(request.chunk));
+            break;
+    }
+
+    m_timings.push_back(timing);
+    return timing.loaded;
+}
+
+bool AssetLoader::finish(Context& ctx)
+{
+    // without workers nothing is decoded until somebody waits
+    if ( 0 == m_jobs.workerCount() )
+        m_jobs.wait(m_counter);
+
+    bool loaded = true;
+    while ( m_finished < m_requests.size() )
+    {
+        std::size_t index;
+        {
+            std::unique_lock lock(m_doneMutex);
+            m_doneSignal.wait(lock, [this]() { return !m_done.empty(); });
+            index = m_done.front();
+            m_done.pop_front();
+        }
+
+        loaded = store(ctx, *m_requests[index]) && loaded;
+        m_requests[index].reset();
+        m_finished++;
+    }
+
+    m_totalMs = m_started ? millisecondsSince(m_start) : 0;
+    return loaded;
+}
+
+void AssetLoader::report(std::ostream& out) const
+{
+    double slowest = 0;
+    double sum = 0;
+    for(const auto& t : m_timings)
+    {
+        out << std::setw(8) << kindName(t.kind) << " " << std::fixed << std::setprecision(2)
+            << std::setw(8) << t.decodeMs << " ms decode " << std::setw(6) << t.uploadMs << " ms upload  "
+            << t.path.string() << (t.loaded ? "" : "  FAILED") << std::endl;
+        slowest = std::max(slowest, t.decodeMs + t.uploadMs);
+        sum += t.decodeMs + t.uploadMs;
+    }
+    out << "Loaded " << m_timings.size() << " assets in " << m_totalMs << " ms (slowest " << slowest
+        << " ms, " << sum << " ms one after another)" << std::endl;
+    out << std::defaultfloat;
+}
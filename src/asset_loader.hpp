@@ -0,0 +1,97 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <SDL.h>
+#include <SDL_ttf.h>
+#include <SDL_mixer.h>
+
+#include "assets.hpp"
+#include "context.hpp"
+#include "job_system.hpp"
+
+// Decodes assets on the job system and hands them to an AssetCache.
+// Requests start decoding right away; finish() does the renderer uploads on the calling thread,
+// after which the assets are served by the cache's usual lookups.
+class AssetLoader
+{
+public:
+    enum class Kind { Texture, Image, Font, Music, Chunk };
+
+    struct Timing
+    {
+        Kind kind;
+        std::filesystem::path path;
+        double decodeMs;  // on a worker
+        double uploadMs;  // on the thread calling finish(), textures only
+        bool loaded;
+    };
+
+    AssetLoader(JobSystem& jobs, AssetCache& assets);
+    // Waits for decoding still in flight, its results are dropped
+    ~AssetLoader();
+
+    AssetLoader(const AssetLoader&) = delete;
+    AssetLoader& operator=(const AssetLoader&) = delete;
+
+    void texture(const std::filesystem::path& path);
+    void image(const std::filesystem::path& path);
+    void font(const std::filesystem::path& path, int pointSize = defaultFontSize);
+    void music(const std::filesystem::path& path);
+    void chunk(const std::filesystem::path& path);
+
+    // Must be called from the thread owning the renderer. Uploads and caches assets in the order
+    // their decoding completes, until all requests are done. False if any of them failed.
+    bool finish(Context& ctx);
+
+    // Per asset in completion order, valid after finish()
+    const std::vector<Timing>& timings() const noexcept {return m_timings;}
+    // From the first request to the end of finish()
+    double totalMs() const noexcept {return m_totalMs;}
+
+    void report(std::ostream& out) const;
+
+private:
+    struct Request
+    {
+        Kind kind;
+        std::filesystem::path path;
+        int pointSize{0};
+
+        std::unique_ptr<SDL_Surface> surface;
+        Font font;
+        MixMusic music;
+        MixChunk chunk;
+        double decodeMs{0};
+    };
+
+    void submit(Kind kind, const std::filesystem::path& path, int pointSize = 0);
+    void decode(Request& request);
+    bool store(Context& ctx, Request& request);
+
+    JobSystem& m_jobs;
+    AssetCache& m_assets;
+    JobSystem::Counter m_counter;
+
+    std::vector<std::unique_ptr<Request>> m_requests;
+    std::size_t m_finished{0};
+
+    // indices of decoded requests, filled by workers and drained by finish()
+    std::mutex m_doneMutex;
+    std::condition_variable m_doneSignal;
+    std::deque<std::size_t> m_done;
+
+    std::chrono::steady_clock::time_point m_start;
+    bool m_started{false};
+    std::vector<Timing> m_timings;
+    double m_totalMs{0};
+};
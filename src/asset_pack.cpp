@@ -0,0 +1,362 @@
+#include <iostream>
+#include <fstream>
+#include <climits>
+#include <cstring>
+#include <iterator>
+
+#include <SDL_image.h>
+#include <SDL_ttf.h>
+#include <SDL_mixer.h>
+
+#include "asset_pack.hpp"
+#include "surface.hpp"
+#include "music.hpp"
+
+namespace
+{
+
+const char packMagic[8] = {'S', 'D', 'L', 'P', 'A', 'C', 'K', 0};
+const std::uint32_t packVersion = 1;
+const std::uint64_t packAlignment = 64;
+
+struct PackHeader
+{
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t headerSize;
+    std::uint32_t entryCount;
+    std::uint32_t entrySize;
+    std::uint32_t pixelFormat;
+    std::uint32_t audioFrequency;
+    std::uint16_t audioFormat;
+    std::uint16_t audioChannels;
+    std::uint32_t reserved;
+    std::uint64_t entriesOffset;
+    std::uint64_t namesOffset;
+};
+
+std::uint64_t alignUp(std::uint64_t v)
+{
+    return (v + packAlignment - 1) / packAlignment * packAlignment;
+}
+
+std::string entryName(const std::filesystem::path& path)
+{
+    return path.lexically_normal().generic_string();
+}
+
+// Decoded, color keyed pixels in AssetPack::pixelFormat, rows packed without padding
+bool bakePixels(const std::filesystem::path& path, AssetPack::Entry& entry, std::vector<std::uint8_t>& data)
+{
+    auto image = loadImage(path);
+    if ( !image )
+        return false;
+
+    // loadImage already hands out pixelFormat with the color key turned into alpha
+    static_assert( AssetPack::pixelFormat == SDL_PIXELFORMAT_ARGB8888 );
+
+    entry.width = image->w;
+    entry.height = image->h;
+    entry.pitch = image->w * 4;
+    data.resize(static_cast<std::size_t>(entry.pitch) * entry.height);
+    const auto* pixels = static_cast<const std::uint8_t*>(image->pixels);
+    for(int y = 0; y < image->h; y++)
+        std::memcpy(data.data() + y * entry.pitch, pixels + y * image->pitch, entry.pitch);
+    return true;
+}
+
+// PCM in the mixer device format, ready for Mix_QuickLoad_RAW
+bool bakePcm(const std::filesystem::path& path, std::vector<std::uint8_t>& data)
+{
+    return loadPcm(path, mixerFrequency, mixerFormat, mixerChannels, data);
+}
+
+bool bakeRaw(const std::filesystem::path& path, std::vector<std::uint8_t>& data)
+{
+    std::ifstream in(path, std::ios::binary);
+    if ( !in )
+    {
+        std::cerr << "Unable to open " << path << std::endl;
+        return false;
+    }
+    data.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    return true;
+}
+
+}
+
+AssetPack::AssetPack(MappedFile&& mapping, std::vector<Entry>&& entries, bool pcmMatchesMixer):
+    m_mapping(std::move(mapping)), m_entries(std::move(entries)), m_pcmMatchesMixer(pcmMatchesMixer)
+{
+    for(std::size_t i = 0; i < m_entries.size(); i++)
+    {
+        const auto* name = reinterpret_cast<const char*>(m_mapping.data() + m_entries[i].nameOffset);
+        m_index.emplace(std::make_pair(m_entries[i].kind, std::string(name, m_entries[i].nameSize)), i);
+    }
+}
+
+const AssetPack::Entry* AssetPack::find(const std::filesystem::path& name, Kind kind) const
+{
+    if ( Kind::Pcm == kind && !m_pcmMatchesMixer )
+        return nullptr;
+
+    auto it = m_index.find(std::make_pair(kind, entryName(name)));
+    return it == m_index.end() ? nullptr : &m_entries[it->second];
+}
+
+bool AssetPack::contains(const std::filesystem::path& name, Kind kind) const
+{
+    return nullptr != find(name, kind);
+}
+
+std::size_t AssetPack::bytes(const std::filesystem::path& name, Kind kind) const
+{
+    const Entry* entry = find(name, kind);
+    return entry ? static_cast<std::size_t>(entry->size) : 0;
+}
+
+ImageHandle AssetPack::image(const std::filesystem::path& name)
+{
+    const Entry* entry = find(name, Kind::Pixels);
+    if ( !entry )
+        return nullptr;
+
+    SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormatFrom( m_mapping.data() + entry->offset,
+        entry->width, entry->height, 32, entry->pitch, pixelFormat );
+    if ( NULL == surface )
+    {
+        std::cerr << "Unable to create surface for " << name << "! SDL_error: " << SDL_GetError() << std::endl;
+        return nullptr;
+    }
+
+    // the surface borrows the pixels, so the pack has to stay mapped
+    return ImageHandle(surface, [pack = shared_from_this()](SDL_Surface* s) { SDL_FreeSurface( s ); });
+}
+
+TextureHandle AssetPack::texture(const std::filesystem::path& name, Context& ctx)
+{
+    const Entry* entry = find(name, Kind::Pixels);
+    if ( !entry )
+        return nullptr;
+
+    SDL_Texture* texture = SDL_CreateTexture( ctx.renderer(), pixelFormat, SDL_TEXTUREACCESS_STATIC,
+        entry->width, entry->height );
+    if ( NULL == texture || 0 != SDL_UpdateTexture( texture, NULL, m_mapping.data() + entry->offset, entry->pitch ) )
+    {
+        std::cerr << "Unable to create texture for " << name << "! SDL_error: " << SDL_GetError() << std::endl;
+        if ( texture )
+            SDL_DestroyTexture( texture );
+        return nullptr;
+    }
+
+    auto result = std::make_shared<Texture>(texture, entry->width, entry->height);
+    result->setBlendMode(SDL_BLENDMODE_BLEND);
+    return result;
+}
+
+FontHandle AssetPack::font(const std::filesystem::path& name, int pointSize)
+{
+    const Entry* entry = find(name, Kind::Raw);
+    if ( !entry )
+        return nullptr;
+
+    SDL_RWops* rw = SDL_RWFromConstMem( m_mapping.data() + entry->offset, static_cast<int>(entry->size) );
+    TTF_Font* font = rw ? TTF_OpenFontRW( rw, 1, pointSize ) : NULL;
+    if ( NULL == font )
+    {
+        std::cerr << "Failed to load font " << name << " from pack! SDL_ttf Error: " << TTF_GetError() << std::endl;
+        return nullptr;
+    }
+
+    // glyphs are read from the mapping on demand
+    return FontHandle(new Font(font), [pack = shared_from_this()](Font* f) { delete f; });
+}
+
+MusicHandle AssetPack::music(const std::filesystem::path& name)
+{
+    const Entry* entry = find(name, Kind::Raw);
+    if ( !entry )
+        return nullptr;
+
+    SDL_RWops* rw = SDL_RWFromConstMem( m_mapping.data() + entry->offset, static_cast<int>(entry->size) );
+    Mix_Music* music = rw ? Mix_LoadMUS_RW( rw, 1 ) : NULL;
+    if ( NULL == music )
+    {
+        std::cerr << "Failed to load music " << name << " from pack! SDL_mixer Error: " << Mix_GetError() << std::endl;
+        return nullptr;
+    }
+
+    // music is streamed from the mapping while it plays
+    return MusicHandle(music, [pack = shared_from_this()](Mix_Music* m) { Mix_FreeMusic( m ); });
+}
+
+ChunkHandle AssetPack::chunk(const std::filesystem::path& name)
+{
+    const Entry* entry = find(name, Kind::Pcm);
+    if ( !entry )
+        return nullptr;
+
+    Mix_Chunk* chunk = Mix_QuickLoad_RAW( m_mapping.data() + entry->offset, static_cast<Uint32>(entry->size) );
+    if ( NULL == chunk )
+    {
+        std::cerr << "Failed to load chunk " << name << " from pack! SDL_mixer Error: " << Mix_GetError() << std::endl;
+        return nullptr;
+    }
+
+    // a quick loaded chunk plays the mapped samples in place and doesn't own them
+    return ChunkHandle(chunk, [pack = shared_from_this()](Mix_Chunk* c) { Mix_FreeChunk( c ); });
+}
+
+std::shared_ptr<AssetPack> openAssetPack(const std::filesystem::path& path)
+{
+    auto mappingOpt = mapFile(path);
+    if ( !mappingOpt )
+        return nullptr;
+    auto mapping = std::move(mappingOpt).value();
+
+    PackHeader header{};
+    if ( mapping.size() < sizeof(PackHeader) )
+    {
+        std::cerr << "Asset pack " << path << " is too short" << std::endl;
+        return nullptr;
+    }
+    std::memcpy(&header, mapping.data(), sizeof(header));
+
+    if ( 0 != std::memcmp(header.magic, packMagic, sizeof(packMagic)) )
+    {
+        std::cerr << path << " is not an asset pack" << std::endl;
+        return nullptr;
+    }
+
+    if ( packVersion != header.version || sizeof(PackHeader) != header.headerSize
+        || sizeof(AssetPack::Entry) != header.entrySize )
+    {
+        std::cerr << "Unsupported asset pack version " << header.version << " in " << path << std::endl;
+        return nullptr;
+    }
+
+    if ( AssetPack::pixelFormat != header.pixelFormat )
+    {
+        std::cerr << "Asset pack " << path << " has pixels in " << SDL_GetPixelFormatName(header.pixelFormat)
+                  << ", rebuild it" << std::endl;
+        return nullptr;
+    }
+
+    const std::uint64_t tableBytes = std::uint64_t(header.entryCount) * sizeof(AssetPack::Entry);
+    if ( header.entriesOffset > mapping.size() || mapping.size() - header.entriesOffset < tableBytes )
+    {
+        std::cerr << "Asset pack " << path << " is truncated or corrupt" << std::endl;
+        return nullptr;
+    }
+
+    std::vector<AssetPack::Entry> entries(header.entryCount);
+    std::memcpy(entries.data(), mapping.data() + header.entriesOffset, tableBytes);
+    for(const auto& e : entries)
+    {
+        const bool nameFits = e.nameOffset <= mapping.size() && mapping.size() - e.nameOffset >= e.nameSize;
+        const bool dataFits = e.offset % packAlignment == 0 && e.offset <= mapping.size() && mapping.size() - e.offset >= e.size;
+        const bool kindKnown = AssetPack::Kind::Pixels == e.kind || AssetPack::Kind::Pcm == e.kind
+            || AssetPack::Kind::Raw == e.kind;
+        // rows of 32 bit pixels, the surface and texture calls take the sizes as int
+        const bool pixelsFit = AssetPack::Kind::Pixels != e.kind
+            || ( e.width > 0 && e.height > 0 && e.pitch <= INT_MAX && e.height <= INT_MAX
+                && std::uint64_t(e.pitch) >= std::uint64_t(e.width) * 4
+                && std::uint64_t(e.pitch) * e.height <= e.size );
+        // SDL_RWFromConstMem takes an int size, entries are handed to it without another check
+        const bool sizeFits = e.size <= INT_MAX;
+        if ( !nameFits || !dataFits || !kindKnown || !pixelsFit || !sizeFits )
+        {
+            std::cerr << "Asset pack " << path << " is truncated or corrupt" << std::endl;
+            return nullptr;
+        }
+    }
+
+    // the mixer may have opened the device in another format than the pack was baked for
+    int frequency = 0;
+    Uint16 format = 0;
+    int channels = 0;
+    const bool pcmMatchesMixer = Mix_QuerySpec( &frequency, &format, &channels )
+        && frequency == static_cast<int>(header.audioFrequency) && format == header.audioFormat
+        && channels == header.audioChannels;
+    if ( !pcmMatchesMixer )
+        std::cerr << "Asset pack " << path << " sounds don't match the mixer format, loading them from files" << std::endl;
+
+    return std::make_shared<AssetPack>(std::move(mapping), std::move(entries), pcmMatchesMixer);
+}
+
+bool writeAssetPack(const std::filesystem::path& path, const std::vector<AssetPackSource>& sources)
+{
+    std::vector<AssetPack::Entry> entries;
+    std::vector<std::vector<std::uint8_t>> blobs;
+    std::string names;
+    for(const auto& source : sources)
+    {
+        AssetPack::Entry entry{};
+        entry.kind = source.kind;
+        std::vector<std::uint8_t> data;
+        bool baked = false;
+        switch (source.kind)
+        {
+            case AssetPack::Kind::Pixels: baked = bakePixels(source.path, entry, data); break;
+            case AssetPack::Kind::Pcm: baked = bakePcm(source.path, data); break;
+            case AssetPack::Kind::Raw: baked = bakeRaw(source.path, data); break;
+        }
+        if ( !baked )
+            return false;
+
+        const std::string name = entryName(source.path);
+        entry.nameOffset = static_cast<std::uint32_t>(names.size());
+        entry.nameSize = static_cast<std::uint32_t>(name.size());
+        entry.size = data.size();
+        names += name;
+        entries.push_back(entry);
+        blobs.push_back(std::move(data));
+    }
+
+    PackHeader header{};
+    std::memcpy(header.magic, packMagic, sizeof(packMagic));
+    header.version = packVersion;
+    header.headerSize = sizeof(PackHeader);
+    header.entryCount = static_cast<std::uint32_t>(entries.size());
+    header.entrySize = sizeof(AssetPack::Entry);
+    header.pixelFormat = AssetPack::pixelFormat;
+    header.audioFrequency = mixerFrequency;
+    header.audioFormat = mixerFormat;
+    header.audioChannels = mixerChannels;
+    header.entriesOffset = sizeof(PackHeader);
+    header.namesOffset = header.entriesOffset + entries.size() * sizeof(AssetPack::Entry);
+
+    std::uint64_t offset = alignUp(header.namesOffset + names.size());
+    for(auto& entry : entries)
+    {
+        entry.nameOffset += header.namesOffset;
+        entry.offset = offset;
+        offset = alignUp(offset + entry.size);
+    }
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if ( !out )
+    {
+        std::cerr << "Unable to create asset pack " << path << std::endl;
+        return false;
+    }
+
+    const char padding[packAlignment] = {};
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(AssetPack::Entry));
+    out.write(names.data(), names.size());
+    std::uint64_t written = header.namesOffset + names.size();
+    for(std::size_t i = 0; i < entries.size(); i++)
+    {
+        out.write(padding, entries[i].offset - written);
+        out.write(reinterpret_cast<const char*>(blobs[i].data()), blobs[i].size());
+        written = entries[i].offset + blobs[i].size();
+    }
+
+    if ( !out.flush() )
+    {
+        std::cerr << "Unable to write asset pack " << path << std::endl;
+        return false;
+    }
+    return true;
+}
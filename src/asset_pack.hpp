@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <SDL.h>
+
+#include "assets.hpp"
+#include "context.hpp"
+#include "mapped_file.hpp"
+
+// Pre-baked media in a single file, made by the sdlpack tool:
+//   header | entry table | names | blobs
+// every blob starts on a 64 byte boundary. Images are stored decoded and color keyed in pixelFormat,
+// sounds as PCM in the mixer device format, fonts and music as the original file bytes.
+// Entries are named by their source path, so the pack serves the same keys as AssetCache.
+// Values are in host byte order.
+class AssetPack : public std::enable_shared_from_this<AssetPack>
+{
+public:
+    enum class Kind : std::uint32_t { Pixels = 1, Pcm = 2, Raw = 3 };
+
+    static constexpr Uint32 pixelFormat = SDL_PIXELFORMAT_ARGB8888;
+
+    struct Entry
+    {
+        Kind kind;
+        std::uint32_t width;
+        std::uint32_t height;
+        std::uint32_t pitch;
+        std::uint64_t offset;
+        std::uint64_t size;
+        std::uint32_t nameOffset;
+        std::uint32_t nameSize;
+    };
+
+    AssetPack(MappedFile&& mapping, std::vector<Entry>&& entries, bool pcmMatchesMixer);
+
+    // Pcm entries only count while the mixer runs in the format they were baked for
+    bool contains(const std::filesystem::path& name, Kind kind) const;
+    // Size of the entry's data, 0 if there is none
+    std::size_t bytes(const std::filesystem::path& name, Kind kind) const;
+    std::size_t size() const noexcept {return m_index.size();}
+
+    // All of these create their asset straight from the mapping, nullptr if the pack has no such entry.
+    // Handles keep the pack mapped for as long as they live.
+    ImageHandle image(const std::filesystem::path& name);
+    TextureHandle texture(const std::filesystem::path& name, Context& ctx);
+    FontHandle font(const std::filesystem::path& name, int pointSize);
+    MusicHandle music(const std::filesystem::path& name);
+    ChunkHandle chunk(const std::filesystem::path& name);
+
+private:
+    const Entry* find(const std::filesystem::path& name, Kind kind) const;
+
+    MappedFile m_mapping;
+    std::vector<Entry> m_entries;
+    std::map<std::pair<Kind, std::string>, std::size_t> m_index;
+    bool m_pcmMatchesMixer{false};
+};
+
+// nullptr if the file is missing, corrupt or made for another pixel format
+std::shared_ptr<AssetPack> openAssetPack(const std::filesystem::path& path);
+
+struct AssetPackSource
+{
+    std::filesystem::path path;
+    AssetPack::Kind kind;
+};
+
+// Decodes every source and writes the pack; used by the sdlpack tool
+bool writeAssetPack(const std::filesystem::path& path, const std::vector<AssetPackSource>& sources);
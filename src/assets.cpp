@@ -0,0 +1,274 @@
+#include <iostream>
+#include <tuple>
+#include <system_error>
+
+#include "assets.hpp"
+#include "asset_pack.hpp"
+#include "sound_bank.hpp"
+
+namespace
+{
+    // Fonts and music are streamed from their files, their size is the best guess of what they keep in memory
+    std::size_t fileBytes(const std::filesystem::path& path)
+    {
+        std::error_code error;
+        const auto bytes = std::filesystem::file_size(path, error);
+        return error ? 0 : static_cast<std::size_t>(bytes);
+    }
+}
+
+bool AssetCache::Key::operator<(const Key& other) const
+{
+    return std::tie(kind, path, param) < std::tie(other.kind, other.path, other.param);
+}
+
+template<typename T, typename Load>
+std::shared_ptr<T> AssetCache::lookup(Kind kind, const std::filesystem::path& path, int param, Load&& load)
+{
+    Key key{kind, path.lexically_normal().generic_string(), param};
+    auto it = m_entries.find(key);
+    if ( it != m_entries.end() )
+    {
+        m_hits++;
+        return std::static_pointer_cast<T>(it->second.asset);
+    }
+
+    m_misses++;
+    std::size_t bytes = 0;
+    std::shared_ptr<T> asset = load(bytes);
+    if ( !asset )
+        return nullptr;
+
+    m_entries.emplace(std::move(key), Entry{asset, bytes});
+    m_insertions++;
+    m_bytesResident += bytes;
+    return asset;
+}
+
+TextureHandle AssetCache::texture(const std::filesystem::path& path, Context& ctx)
+{
+    return lookup<Texture>(Kind::Texture, path, 0, [&](std::size_t& bytes) -> TextureHandle {
+        if ( m_pack && m_pack->contains(path, AssetPack::Kind::Pixels) )
+        {
+            auto texture = m_pack->texture(path, ctx);
+            bytes = texture ? textureBytes(texture->texture()) : 0;
+            return texture;
+        }
+
+        auto texture = loadTexture(path, ctx);
+        if ( !texture )
+            return nullptr;
+
+        bytes = textureBytes(texture->texture());
+        return std::make_shared<Texture>(std::move(texture).value());
+    });
+}
+
+ImageHandle AssetCache::image(const std::filesystem::path& path)
+{
+    return lookup<SDL_Surface>(Kind::Image, path, 0, [&](std::size_t& bytes) -> ImageHandle {
+        if ( m_pack && m_pack->contains(path, AssetPack::Kind::Pixels) )
+        {
+            bytes = m_pack->bytes(path, AssetPack::Kind::Pixels);
+            return m_pack->image(path);
+        }
+
+        auto surface = loadImage(path);
+        if ( !surface )
+            return nullptr;
+
+        bytes = static_cast<std::size_t>(surface->pitch) * surface->h;
+        return ImageHandle(std::move(surface));
+    });
+}
+
+FontHandle AssetCache::font(const std::filesystem::path& path, int pointSize)
+{
+    return lookup<Font>(Kind::Font, path, pointSize, [&](std::size_t& bytes) -> FontHandle {
+        if ( m_pack && m_pack->contains(path, AssetPack::Kind::Raw) )
+        {
+            bytes = m_pack->bytes(path, AssetPack::Kind::Raw);
+            return m_pack->font(path, pointSize);
+        }
+
+        auto font = loadFont(path, pointSize);
+        if ( !font )
+            return nullptr;
+
+        bytes = fileBytes(path);
+        return std::make_shared<Font>(std::move(font));
+    });
+}
+
+MusicHandle AssetCache::music(const std::filesystem::path& path)
+{
+    return lookup<Mix_Music>(Kind::Music, path, 0, [&](std::size_t& bytes) -> MusicHandle {
+        if ( m_pack && m_pack->contains(path, AssetPack::Kind::Raw) )
+        {
+            bytes = m_pack->bytes(path, AssetPack::Kind::Raw);
+            return m_pack->music(path);
+        }
+
+        auto music = loadMusic(path);
+        if ( !music )
+            return nullptr;
+
+        bytes = fileBytes(path);
+        return MusicHandle(std::move(music));
+    });
+}
+
+ChunkHandle AssetCache::chunk(const std::filesystem::path& path)
+{
+    return lookup<Mix_Chunk>(Kind::Chunk, path, 0, [&](std::size_t& bytes) -> ChunkHandle {
+        if ( m_soundBank && m_soundBank->contains(path) )
+        {
+            bytes = m_soundBank->bytes(path);
+            return m_soundBank->chunk(path);
+        }
+        if ( m_pack && m_pack->contains(path, AssetPack::Kind::Pcm) )
+        {
+            bytes = m_pack->bytes(path, AssetPack::Kind::Pcm);
+            return m_pack->chunk(path);
+        }
+
+        auto chunk = loadChunk(path);
+        if ( !chunk )
+            return nullptr;
+
+        bytes = chunk->alen;
+        return ChunkHandle(std::move(chunk));
+    });
+}
+
+TextureHandle AssetCache::insert(const std::filesystem::path& path, Texture&& texture)
+{
+    return lookup<Texture>(Kind::Texture, path, 0, [&](std::size_t& bytes) {
+        bytes = textureBytes(texture.texture());
+        return std::make_shared<Texture>(std::move(texture));
+    });
+}
+
+ImageHandle AssetCache::insert(const std::filesystem::path& path, std::unique_ptr<SDL_Surface>&& image)
+{
+    return lookup<SDL_Surface>(Kind::Image, path, 0, [&](std::size_t& bytes) {
+        bytes = image ? static_cast<std::size_t>(image->pitch) * image->h : 0;
+        return ImageHandle(std::move(image));
+    });
+}
+
+FontHandle AssetCache::insert(const std::filesystem::path& path, int pointSize, Font&& font)
+{
+    return lookup<Font>(Kind::Font, path, pointSize, [&](std::size_t& bytes) {
+        bytes = fileBytes(path);
+        return std::make_shared<Font>(std::move(font));
+    });
+}
+
+MusicHandle AssetCache::insert(const std::filesystem::path& path, MixMusic&& music)
+{
+    return lookup<Mix_Music>(Kind::Music, path, 0, [&](std::size_t& bytes) {
+        bytes = fileBytes(path);
+        return MusicHandle(std::move(music));
+    });
+}
+
+ChunkHandle AssetCache::insert(const std::filesystem::path& path, MixChunk&& chunk)
+{
+    return lookup<Mix_Chunk>(Kind::Chunk, path, 0, [&](std::size_t& bytes) {
+        bytes = chunk ? chunk->alen : 0;
+        return ChunkHandle(std::move(chunk));
+    });
+}
+
+AssetCache::Entry* AssetCache::find(Kind kind, const std::filesystem::path& path, int param)
+{
+    auto it = m_entries.find(Key{kind, path.lexically_normal().generic_string(), param});
+    return it == m_entries.end() ? nullptr : &it->second;
+}
+
+bool AssetCache::reload(const std::filesystem::path& path, Texture&& texture)
+{
+    Entry* entry = find(Kind::Texture, path, 0);
+    if ( !entry )
+        return false;
+
+    const std::size_t bytes = textureBytes(texture.texture());
+    *std::static_pointer_cast<Texture>(entry->asset) = std::move(texture);
+    m_bytesResident += bytes - entry->bytes;
+    entry->bytes = bytes;
+    return true;
+}
+
+bool AssetCache::reload(const std::filesystem::path& path, ImageHandle image)
+{
+    Entry* entry = find(Kind::Image, path, 0);
+    if ( !entry || !image )
+        return false;
+
+    const std::size_t bytes = static_cast<std::size_t>(image->pitch) * image->h;
+    entry->asset = std::move(image);
+    m_bytesResident += bytes - entry->bytes;
+    entry->bytes = bytes;
+    return true;
+}
+
+bool AssetCache::reload(const std::filesystem::path& path, int pointSize, Font&& font)
+{
+    Entry* entry = find(Kind::Font, path, pointSize);
+    if ( !entry || !font )
+        return false;
+
+    *std::static_pointer_cast<Font>(entry->asset) = std::move(font);
+    return true;
+}
+
+bool AssetCache::reload(const std::filesystem::path& path, MixChunk&& chunk)
+{
+    Entry* entry = find(Kind::Chunk, path, 0);
+    if ( !entry || !chunk )
+        return false;
+
+    auto cached = std::static_pointer_cast<Mix_Chunk>(entry->asset);
+
+    // the mixer thread reads the samples while a channel plays them
+    const int channels = Mix_AllocateChannels( -1 );
+    for(int channel = 0; channel < channels; channel++)
+        if ( Mix_Playing( channel ) && Mix_GetChunk( channel ) == cached.get() )
+            Mix_HaltChannel( channel );
+    for(const ChunkReleaser& release : m_chunkReleasers)
+        release(*cached);
+
+    // the old samples leave with the new chunk object and are freed by its deleter
+    std::swap(*cached, *chunk);
+    const std::size_t bytes = cached->alen;
+    m_bytesResident += bytes - entry->bytes;
+    entry->bytes = bytes;
+    return true;
+}
+
+std::vector<AssetCache::Key> AssetCache::keys() const
+{
+    std::vector<Key> keys;
+    keys.reserve(m_entries.size());
+    for(const auto& [key, entry] : m_entries)
+        keys.push_back(key);
+    return keys;
+}
+
+std::size_t AssetCache::purgeUnused()
+{
+    std::size_t purged = 0;
+    for(auto it = m_entries.begin(); it != m_entries.end(); )
+    {
+        if ( 1 == it->second.asset.use_count() )
+        {
+            m_bytesResident -= it->second.bytes;
+            it = m_entries.erase(it);
+            purged++;
+        }
+        else
+            ++it;
+    }
+    return purged;
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <SDL.h>
+#include <SDL_ttf.h>
+#include <SDL_mixer.h>
+
+#include "context.hpp"
+#include "texture.hpp"
+#include "surface.hpp"
+#include "font.hpp"
+#include "music.hpp"
+
+class AssetPack;
+class SoundBank;
+
+using TextureHandle = std::shared_ptr<Texture>;
+using ImageHandle = std::shared_ptr<SDL_Surface>;
+// one more indirection than the others: TTF_Font is opaque, so a reload swaps the Font behind the handle
+using FontHandle = std::shared_ptr<Font>;
+using MusicHandle = std::shared_ptr<Mix_Music>;
+using ChunkHandle = std::shared_ptr<Mix_Chunk>;
+
+// Loads every asset once per path and load parameters and hands out shared handles to it.
+// Lookups return nullptr when the asset can't be loaded; failures are not cached, so a later lookup retries.
+// With a pack mounted, assets it contains come from the pack instead of their files; a mounted sound bank does
+// the same for chunks and goes before the pack.
+class AssetCache
+{
+public:
+    AssetCache() = default;
+    AssetCache(const AssetCache&) = delete;
+    AssetCache& operator=(const AssetCache&) = delete;
+
+    void mount(std::shared_ptr<AssetPack> pack) {m_pack = std::move(pack);}
+    const AssetPack* pack() const noexcept {return m_pack.get();}
+    void mount(std::shared_ptr<SoundBank> bank) {m_soundBank = std::move(bank);}
+    const SoundBank* soundBank() const noexcept {return m_soundBank.get();}
+
+    // Same as loadTexture
+    TextureHandle texture(const std::filesystem::path& path, Context& ctx);
+    // Decoded image with white made transparent, e.g. for AtlasBuilder
+    ImageHandle image(const std::filesystem::path& path);
+    FontHandle font(const std::filesystem::path& path, int pointSize = defaultFontSize);
+    MusicHandle music(const std::filesystem::path& path);
+    ChunkHandle chunk(const std::filesystem::path& path);
+
+    // Hands over assets loaded elsewhere, e.g. by AssetLoader.
+    // If the key is already cached the given asset is dropped and the cached one returned.
+    TextureHandle insert(const std::filesystem::path& path, Texture&& texture);
+    ImageHandle insert(const std::filesystem::path& path, std::unique_ptr<SDL_Surface>&& image);
+    FontHandle insert(const std::filesystem::path& path, int pointSize, Font&& font);
+    MusicHandle insert(const std::filesystem::path& path, MixMusic&& music);
+    ChunkHandle insert(const std::filesystem::path& path, MixChunk&& chunk);
+
+    // Replaces a cached asset with a newer version, e.g. after its file changed. Textures, fonts and chunks are
+    // swapped in place, so every handle already given out sees the new one; chunks still playing are halted first.
+    // Images are replaced in the cache only, holders of the old surface keep it. False if the key isn't cached.
+    bool reload(const std::filesystem::path& path, Texture&& texture);
+    bool reload(const std::filesystem::path& path, ImageHandle image);
+    bool reload(const std::filesystem::path& path, int pointSize, Font&& font);
+    bool reload(const std::filesystem::path& path, MixChunk&& chunk);
+
+    // Called with a chunk about to be swapped by reload(), for whatever else plays chunks, e.g. Mixer::release
+    using ChunkReleaser = std::function<void(Mix_Chunk&)>;
+    void onChunkRelease(ChunkReleaser releaser) {m_chunkReleasers.push_back(std::move(releaser));}
+
+    enum class Kind { Texture, Image, Font, Music, Chunk };
+
+    struct Key
+    {
+        Kind kind;
+        std::string path;
+        int param;
+
+        bool operator<(const Key& other) const;
+    };
+
+    // Everything cached, e.g. to know what a file watcher has to look at
+    std::vector<Key> keys() const;
+
+    // Drops the assets nobody but the cache holds anymore, returns how many
+    std::size_t purgeUnused();
+
+    std::size_t size() const noexcept {return m_entries.size();}
+    // Entries ever added; unlike size() it changes whenever keys() may hold a new key, purges or not
+    std::size_t insertions() const noexcept {return m_insertions;}
+    std::size_t hits() const noexcept {return m_hits;}
+    std::size_t misses() const noexcept {return m_misses;}
+    // Estimated memory held by cached assets, in bytes
+    std::size_t bytesResident() const noexcept {return m_bytesResident;}
+
+private:
+    struct Entry
+    {
+        std::shared_ptr<void> asset;
+        std::size_t bytes;
+    };
+
+    template<typename T, typename Load>
+    std::shared_ptr<T> lookup(Kind kind, const std::filesystem::path& path, int param, Load&& load);
+
+    Entry* find(Kind kind, const std::filesystem::path& path, int param);
+
+    std::shared_ptr<AssetPack> m_pack;
+    std::shared_ptr<SoundBank> m_soundBank;
+    std::map<Key, Entry> m_entries;
+    std::vector<ChunkReleaser> m_chunkReleasers;
+    std::size_t m_insertions{0};
+    std::size_t m_hits{0};
+    std::size_t m_misses{0};
+    std::size_t m_bytesResident{0};
+};
@@ -0,0 +1,247 @@
+#include <iostream>
+#include <algorithm>
+#include <numeric>
+
+#include <SDL.h>
+#include <SDL_image.h>
+
+#include "atlas.hpp"
+#include "pixel_convert.hpp"
+
+SkylinePacker::SkylinePacker(int width, int height): m_width(width), m_height(height)
+{
+    m_skyline.push_back({0, 0, width});
+}
+
+int SkylinePacker::fitAt(std::size_t i, int w, int h) const
+{
+    const int x = m_skyline[i].x;
+    if ( x + w > m_width )
+        return -1;
+
+    int y = 0;
+    int left = w;
+    for(std::size_t j = i; left > 0; j++)
+    {
+        y = std::max(y, m_skyline[j].y);
+        if ( y + h > m_height )
+            return -1;
+        left -= m_skyline[j].w;
+    }
+    return y;
+}
+
+std::optional<SDL_Rect> SkylinePacker::insert(int w, int h)
+{
+    std::size_t best = m_skyline.size();
+    int bestY = 0;
+    int bestW = 0;
+    for(std::size_t i = 0; i < m_skyline.size(); i++)
+    {
+        const int y = fitAt(i, w, h);
+        if ( y < 0 )
+            continue;
+        // lowest top edge first, then the narrowest spot
+        if ( best == m_skyline.size() || y < bestY || (y == bestY && m_skyline[i].w < bestW) )
+        {
+            best = i;
+            bestY = y;
+            bestW = m_skyline[i].w;
+        }
+    }
+
+    if ( best == m_skyline.size() )
+        return std::nullopt;
+
+    const SDL_Rect rect{ m_skyline[best].x, bestY, w, h };
+
+    // the new segment replaces everything it covers
+    m_skyline.insert(m_skyline.begin() + best, {rect.x, rect.y + h, w});
+    for(std::size_t i = best + 1; i < m_skyline.size(); )
+    {
+        Segment& s = m_skyline[i];
+        const int covered = rect.x + w - s.x;
+        if ( covered <= 0 )
+            break;
+        if ( covered < s.w )
+        {
+            s.x += covered;
+            s.w -= covered;
+            break;
+        }
+        m_skyline.erase(m_skyline.begin() + i);
+    }
+
+    for(std::size_t i = 0; i + 1 < m_skyline.size(); )
+    {
+        if ( m_skyline[i].y == m_skyline[i + 1].y )
+        {
+            m_skyline[i].w += m_skyline[i + 1].w;
+            m_skyline.erase(m_skyline.begin() + i + 1);
+        }
+        else
+            i++;
+    }
+
+    return rect;
+}
+
+int SkylinePacker::usedHeight() const noexcept
+{
+    int h = 0;
+    for(const Segment& s : m_skyline)
+        h = std::max(h, s.y);
+    return h;
+}
+
+void TextureRegion::renderAt(Context& ctx, int x, int y)
+{
+    SDL_Rect rect{.x = x, .y = y, .w = m_rect.w, .h = m_rect.h };
+    SDL_RenderCopy( ctx.renderer(), m_texture, &m_rect, &rect);
+}
+
+void TextureRegion::render(Context& ctx, const SDL_Rect* dst, const SDL_Rect* clip, double angle, SDL_RendererFlip flip)
+{
+    SDL_Rect src = m_rect;
+    if ( clip )
+        src = SDL_Rect{ m_rect.x + clip->x, m_rect.y + clip->y, clip->w, clip->h };
+
+    if ( 0 == angle && SDL_FLIP_NONE == flip )
+        SDL_RenderCopy( ctx.renderer(), m_texture, &src, dst );
+    else
+        SDL_RenderCopyEx( ctx.renderer(), m_texture, &src, dst, angle, NULL, flip );
+}
+
+TextureRegion TextureAtlas::region(Handle handle)
+{
+    const auto& [page, rect] = m_regions.at(handle);
+    return TextureRegion(m_pages[page].texture(), rect);
+}
+
+bool TextureAtlas::update(Handle handle, SDL_Surface* surface)
+{
+    const auto& [page, rect] = m_regions.at(handle);
+    if ( surface->w != rect.w || surface->h != rect.h )
+    {
+        std::cerr << "Image of " << rect.w << "x" << rect.h << " changed its size to " << surface->w << "x"
+                  << surface->h << ", the atlas has to be built again" << std::endl;
+        return false;
+    }
+
+    // same pixels as build(): color keyed ones stay transparent
+    auto pixels = convertToArgb8888(surface);
+    if ( !pixels )
+        return false;
+
+    if ( 0 != SDL_UpdateTexture( m_pages[page].texture(), &rect, pixels->pixels, pixels->pitch ) )
+    {
+        std::cerr << "Unable to update atlas texture! SDL_error: " << SDL_GetError() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+TextureAtlas::Handle AtlasBuilder::add(std::unique_ptr<SDL_Surface>&& surface)
+{
+    m_surfaces.push_back(std::move(surface));
+    return m_surfaces.size() - 1;
+}
+
+TextureAtlas::Handle AtlasBuilder::add(const std::shared_ptr<SDL_Surface>& surface)
+{
+    // the same cached image added twice is packed once
+    auto it = std::find(m_surfaces.begin(), m_surfaces.end(), surface);
+    if ( it != m_surfaces.end() )
+        return static_cast<TextureAtlas::Handle>(it - m_surfaces.begin());
+
+    m_surfaces.push_back(surface);
+    return m_surfaces.size() - 1;
+}
+
+std::optional<TextureAtlas::Handle> AtlasBuilder::addImage(const std::filesystem::path& path)
+{
+    auto surface = loadImage(path);
+    if ( !surface )
+        return std::nullopt;
+    return add(std::move(surface));
+}
+
+std::optional<TextureAtlas> AtlasBuilder::build(Context& ctx)
+{
+    int pageSize = m_pageSize;
+    SDL_RendererInfo info;
+    if ( 0 == SDL_GetRendererInfo( ctx.renderer(), &info ) && info.max_texture_width > 0 && info.max_texture_height > 0 )
+        pageSize = std::min({pageSize, info.max_texture_width, info.max_texture_height});
+
+    // tallest first keeps the skyline flat
+    std::vector<std::size_t> order(m_surfaces.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [this](std::size_t a, std::size_t b) {
+        return m_surfaces[a]->h > m_surfaces[b]->h;
+    });
+
+    std::vector<SkylinePacker> packers;
+    std::vector<std::pair<std::size_t, SDL_Rect>> regions(m_surfaces.size());
+    for(std::size_t i : order)
+    {
+        const int w = m_surfaces[i]->w + 2 * m_padding;
+        const int h = m_surfaces[i]->h + 2 * m_padding;
+        if ( w > pageSize || h > pageSize )
+        {
+            std::cerr << "Image of " << m_surfaces[i]->w << "x" << m_surfaces[i]->h
+                      << " doesn't fit into an atlas page of " << pageSize << std::endl;
+            return std::nullopt;
+        }
+
+        std::optional<SDL_Rect> rect;
+        std::size_t page = 0;
+        for(; page < packers.size(); page++)
+            if ( (rect = packers[page].insert(w, h)) )
+                break;
+
+        if ( !rect )
+        {
+            packers.emplace_back(pageSize, pageSize);
+            rect = packers.back().insert(w, h);
+        }
+
+        regions[i] = { page, SDL_Rect{ rect->x + m_padding, rect->y + m_padding, m_surfaces[i]->w, m_surfaces[i]->h } };
+    }
+
+    std::vector<Texture> pages;
+    for(std::size_t page = 0; page < packers.size(); page++)
+    {
+        const int h = packers[page].usedHeight();
+        std::unique_ptr<SDL_Surface> pageSurface(SDL_CreateRGBSurfaceWithFormat( 0, pageSize, h, 32, SDL_PIXELFORMAT_ARGB8888 ));
+        if ( !pageSurface )
+        {
+            std::cerr << "Unable to create atlas page! SDL_error: " << SDL_GetError() << std::endl;
+            return std::nullopt;
+        }
+
+        // a fresh surface is all zeroes, i.e. transparent
+        for(std::size_t i = 0; i < m_surfaces.size(); i++)
+        {
+            if ( regions[i].first != page )
+                continue;
+            SDL_Rect dst = regions[i].second;
+            SDL_BlendMode blendMode;
+            SDL_GetSurfaceBlendMode( m_surfaces[i].get(), &blendMode );
+            SDL_SetSurfaceBlendMode( m_surfaces[i].get(), SDL_BLENDMODE_NONE );
+            SDL_BlitSurface( m_surfaces[i].get(), NULL, pageSurface.get(), &dst );
+            SDL_SetSurfaceBlendMode( m_surfaces[i].get(), blendMode );
+        }
+
+        SDL_Texture* texture = SDL_CreateTextureFromSurface( ctx.renderer(), pageSurface.get() );
+        if ( NULL == texture )
+        {
+            std::cerr << "Unable to create atlas texture! SDL_error: " << SDL_GetError() << std::endl;
+            return std::nullopt;
+        }
+        pages.emplace_back(texture, pageSize, h);
+        pages.back().setBlendMode(SDL_BLENDMODE_BLEND);
+    }
+
+    m_surfaces.clear();
+    return TextureAtlas(std::move(pages), std::move(regions));
+}
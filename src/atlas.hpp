@@ -0,0 +1,119 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include <SDL.h>
+
+#include "context.hpp"
+#include "surface.hpp"
+#include "texture.hpp"
+
+// Bottom-left skyline rectangle packer for one atlas page
+class SkylinePacker
+{
+public:
+    SkylinePacker(int width, int height);
+
+    std::optional<SDL_Rect> insert(int w, int h);
+
+    // Lowest row that is still free everywhere, i.e. how tall the page really needs to be
+    int usedHeight() const noexcept;
+
+private:
+    struct Segment
+    {
+        int x;
+        int y;
+        int w;
+    };
+
+    // y of the lowest free row above [x, x + w), or -1 if it doesn't fit from segment i
+    int fitAt(std::size_t i, int w, int h) const;
+
+    int m_width{0};
+    int m_height{0};
+    std::vector<Segment> m_skyline;
+};
+
+// Part of an atlas page. Only valid while its TextureAtlas is alive.
+class TextureRegion
+{
+public:
+    TextureRegion(SDL_Texture* texture, const SDL_Rect& rect): m_texture(texture), m_rect(rect) {}
+
+    SDL_Texture* texture() noexcept { return m_texture; }
+    const SDL_Rect& rect() const noexcept { return m_rect; }
+
+    int width() const noexcept {return m_rect.w;}
+    int height() const noexcept {return m_rect.h;}
+
+    // Same as Texture::renderAt
+    void renderAt(Context&, int x, int y);
+
+    // Mods belong to the whole page: set them right before drawing and restore afterwards
+    void setColorMod(std::uint8_t r, std::uint8_t g, std::uint8_t b)
+    {
+        SDL_SetTextureColorMod( m_texture, r, g, b );
+    }
+
+    void setAlphaMod(std::uint8_t a)
+    {
+        SDL_SetTextureAlphaMod( m_texture, a );
+    }
+
+    // clip is relative to the region, nullptr means all of it; dst nullptr means the whole target
+    void render(Context&, const SDL_Rect* dst, const SDL_Rect* clip = nullptr,
+        double angle = 0, SDL_RendererFlip flip = SDL_FLIP_NONE);
+
+private:
+    SDL_Texture* m_texture;
+    SDL_Rect m_rect;
+};
+
+class TextureAtlas
+{
+public:
+    using Handle = std::size_t;
+
+    TextureAtlas(std::vector<Texture>&& pages, std::vector<std::pair<std::size_t, SDL_Rect>>&& regions):
+        m_pages(std::move(pages)), m_regions(std::move(regions)) {}
+
+    TextureRegion region(Handle handle);
+
+    // Overwrites an image in its page, e.g. after the file changed. The size has to stay the same,
+    // a different one needs the atlas to be built again.
+    bool update(Handle handle, SDL_Surface* surface);
+
+    std::size_t pageCount() const noexcept {return m_pages.size();}
+    Texture& page(std::size_t i) noexcept {return m_pages[i];}
+
+private:
+    std::vector<Texture> m_pages;
+    std::vector<std::pair<std::size_t, SDL_Rect>> m_regions;  // page index and rect for every handle
+};
+
+// Collects surfaces, then packs them into as few pages as possible and uploads each page once.
+class AtlasBuilder
+{
+public:
+    explicit AtlasBuilder(int pageSize = 2048, int padding = 1): m_pageSize(pageSize), m_padding(padding) {}
+
+    TextureAtlas::Handle add(std::unique_ptr<SDL_Surface>&& surface);
+    // Shared surfaces, e.g. from AssetCache::image, are only read and released after build
+    TextureAtlas::Handle add(const std::shared_ptr<SDL_Surface>& surface);
+
+    // Loads an image with white made transparent, like loadTexture
+    std::optional<TextureAtlas::Handle> addImage(const std::filesystem::path& path);
+
+    std::optional<TextureAtlas> build(Context& ctx);
+
+private:
+    int m_pageSize{2048};
+    int m_padding{1};
+    std::vector<std::shared_ptr<SDL_Surface>> m_surfaces;
+};
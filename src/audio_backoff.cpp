@@ -0,0 +1,70 @@
+#include <iostream>
+
+#include "audio_backoff.hpp"
+
+namespace
+{
+    const std::chrono::seconds settleTime{1};
+}
+
+AudioBackoff::AudioBackoff(Context& ctx, Mixer& mixer, std::size_t underruns, clock::duration window, int maxChunkSize):
+    m_ctx(ctx), m_mixer(mixer), m_threshold(underruns), m_window(window), m_maxChunkSize(maxChunkSize)
+{
+    const auto now = clock::now();
+    m_settled = now + settleTime;
+    restartWindow(now);
+}
+
+void AudioBackoff::restartWindow(clock::time_point now)
+{
+    m_windowStart = now;
+    m_windowUnderruns = m_mixer.stats().underruns;
+}
+
+bool AudioBackoff::poll(Mix_Music* music)
+{
+    const auto now = clock::now();
+    if ( now < m_settled || now - m_windowStart > m_window )
+    {
+        restartWindow(now);
+        return false;
+    }
+    if ( m_mixer.stats().underruns - m_windowUnderruns < m_threshold )
+        return false;
+
+    const auto& current = m_ctx.audio();
+    if ( !current || current->chunkSize * 2 > m_maxChunkSize )
+    {
+        // nothing left to try, don't look again before the next window
+        restartWindow(now);
+        return false;
+    }
+
+    AudioProfile larger = *current;
+    larger.name = "backoff";
+    larger.chunkSize *= 2;
+
+    const bool resumeMusic = music && Mix_PlayingMusic() && !Mix_PausedMusic();
+    // the voices live in the mixer and carry on where they were once it is back
+    m_mixer.uninstall();
+    const bool reopened = m_ctx.reopenAudio(larger);
+    if ( m_ctx.audio() )
+        m_mixer.install();
+    if ( resumeMusic && m_ctx.audio() )
+        Mix_PlayMusic( music, -1 );
+
+    if ( reopened )
+    {
+        m_backoffs++;
+        std::cout << "Audio underruns, buffer raised to " << larger.chunkSize << " samples ("
+                  << larger.latencyMs() << " ms)" << std::endl;
+    }
+    else
+    {
+        // the device won't take it, every further attempt would only cut the audio again
+        m_maxChunkSize = current ? current->chunkSize : 0;
+    }
+    m_settled = now + settleTime;
+    restartWindow(now);
+    return reopened;
+}
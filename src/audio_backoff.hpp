@@ -0,0 +1,46 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+
+#include <SDL_mixer.h>
+
+#include "context.hpp"
+#include "mixer.hpp"
+
+// Runs the audio device with the smallest buffer that keeps up on this machine: starts with the context's
+// profile and, whenever the mixer counts underruns in quick succession, reopens the device with twice the buffer.
+// The sample rate stays, so loaded chunks remain in the device format. Buffers never shrink again.
+class AudioBackoff
+{
+public:
+    using clock = std::chrono::steady_clock;
+
+    // underruns within window trigger a back-off; maxChunkSize is where it gives up and lives with them
+    AudioBackoff(Context& ctx, Mixer& mixer, std::size_t underruns = 3,
+        clock::duration window = std::chrono::seconds(2), int maxChunkSize = 8192);
+
+    AudioBackoff(const AudioBackoff&) = delete;
+    AudioBackoff& operator=(const AudioBackoff&) = delete;
+
+    // Once per frame. SDL_mixer halts music when the device closes; music that was playing is started
+    // again from its beginning. True if the device was reopened.
+    bool poll(Mix_Music* music = nullptr);
+
+    std::size_t backoffs() const noexcept {return m_backoffs;}
+
+private:
+    void restartWindow(clock::time_point now);
+
+    Context& m_ctx;
+    Mixer& m_mixer;
+    std::size_t m_threshold;
+    clock::duration m_window;
+    int m_maxChunkSize;
+
+    clock::time_point m_windowStart;
+    std::size_t m_windowUnderruns{0};  // the mixer's count when the window started
+    // a freshly opened device fills its buffers in bursts, callbacks aren't judged until it settles
+    clock::time_point m_settled;
+    std::size_t m_backoffs{0};
+};
@@ -47,6 +47,8 @@ public:
   vec2& v() noexcept {return m_v;}
   const vec2& v() const noexcept {return m_v;}
 
+  float r() const noexcept {return m_r;}
+
   void render(Context& ctx)
   {
       SDL_Rect fillRect = { static_cast<int>(m_p.x() - m_r), static_cast<int>(m_p.y() - m_r),
@@ -0,0 +1,432 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <iterator>
+
+#include <SDL.h>
+
+#include "context.hpp"
+#include "job_system.hpp"
+#include "camera.hpp"
+#include "particles.hpp"
+#include "scene.hpp"
+#include "atlas.hpp"
+#include "animation.hpp"
+#include "texture_residency.hpp"
+#include "mixer.hpp"
+#include "profiler.hpp"
+
+namespace
+{
+
+using clock = std::chrono::steady_clock;
+
+struct Result
+{
+    std::size_t balls{0};
+    unsigned threads{0};
+    bool collisions{false};
+    double constructMs{0};
+    double updateNsPerBall{0};
+    double submitNsPerBall{0};
+    double renderNsPerBall{0};
+    std::uint64_t pairsTestedPerStep{0};
+    std::size_t drawCalls{0};
+};
+
+double nanoseconds(clock::duration d)
+{
+    return std::chrono::duration<double, std::nano>(d).count();
+}
+
+// Enough iterations to keep every measurement around the same wall time
+int iterationsFor(std::size_t balls, double budget)
+{
+    return static_cast<int>(std::clamp(budget / balls, 3.0, 1000.0));
+}
+
+Result run(Context& ctx, JobSystem* jobs, std::size_t balls, bool collisions)
+{
+    Result r;
+    r.balls = balls;
+    r.threads = jobs ? jobs->workerCount() + 1 : 1;
+    r.collisions = collisions;
+
+    const auto constructStart = clock::now();
+    Scene scene(balls, jobs);
+    r.constructMs = std::chrono::duration<double, std::milli>(clock::now() - constructStart).count();
+    scene.setCollisions(collisions);
+
+    const auto step = std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(1.0 / 120));
+
+    // warm up caches and the job system
+    scene.update(step);
+
+    const int updates = iterationsFor(balls, 2e7);
+    scene.grid().resetCounters();
+    const auto updateStart = clock::now();
+    for(int i = 0; i < updates; i++)
+        scene.update(step);
+    r.updateNsPerBall = nanoseconds(clock::now() - updateStart) / updates / balls;
+    r.pairsTestedPerStep = scene.grid().pairsTested() / updates;
+
+    // the default world is exactly the window, so nothing gets culled
+    const Camera camera(ctx.width(), ctx.height());
+    const int renders = iterationsFor(balls, 2e6);
+    clock::duration submit{0};
+    clock::duration total{0};
+    for(int i = 0; i < renders; i++)
+    {
+        SDL_SetRenderDrawColor( ctx.renderer(), 0xFF, 0xFF, 0xFF, 0xFF );
+        SDL_RenderClear( ctx.renderer() );
+        SDL_RenderFlush( ctx.renderer() );
+
+        const auto renderStart = clock::now();
+        scene.render(ctx, camera, 0.5f);
+        const auto submitted = clock::now();
+        SDL_RenderFlush( ctx.renderer() );
+        const auto flushed = clock::now();
+
+        submit += submitted - renderStart;
+        total += flushed - renderStart;
+    }
+    r.submitNsPerBall = nanoseconds(submit) / renders / balls;
+    r.renderNsPerBall = nanoseconds(total) / renders / balls;
+    r.drawCalls = scene.drawCalls();
+
+    return r;
+}
+
+struct SpriteResult
+{
+    std::size_t sprites{0};
+    double updateNsPerSprite{0};
+    double renderNsPerSprite{0};
+    std::size_t drawCalls{0};
+};
+
+// A crowd of walkers spread over the window, each at its own point of the clip
+SpriteResult runSprites(Context& ctx, TextureRegion sheet, const AnimationSet& set, std::size_t sprites)
+{
+    SpriteResult r;
+    r.sprites = sprites;
+
+    SpriteAnimator animator;
+    const auto sheetId = animator.addSheet(set, sheet);
+    const float duration = set.clip(0).duration;
+    for(std::size_t i = 0; i < sprites; i++)
+    {
+        const float x = static_cast<float>((i * 37) % (ctx.width() - 64));
+        const float y = static_cast<float>((i * 53) % (ctx.height() - 64));
+        animator.add(sheetId, 0, SDL_FRect{ x, y, 64, 64 }, 1.0f, duration * (i % 16) / 16);
+    }
+
+    const int updates = iterationsFor(sprites, 2e7);
+    const auto updateStart = clock::now();
+    for(int i = 0; i < updates; i++)
+        animator.update(1.0f / 120);
+    r.updateNsPerSprite = nanoseconds(clock::now() - updateStart) / updates / sprites;
+
+    const int renders = iterationsFor(sprites, 2e6);
+    clock::duration total{0};
+    for(int i = 0; i < renders; i++)
+    {
+        SDL_RenderClear( ctx.renderer() );
+        SDL_RenderFlush( ctx.renderer() );
+        const auto renderStart = clock::now();
+        animator.render(ctx);
+        SDL_RenderFlush( ctx.renderer() );
+        total += clock::now() - renderStart;
+    }
+    r.renderNsPerSprite = nanoseconds(total) / renders / sprites;
+    r.drawCalls = animator.drawCalls();
+    return r;
+}
+
+void printSpritesCSV(std::ostream& os, const std::vector<SpriteResult>& results)
+{
+    os << "sprites,update_ns_per_sprite,render_ns_per_sprite,draw_calls\n";
+    for(const SpriteResult& r : results)
+        os << r.sprites << ',' << r.updateNsPerSprite << ',' << r.renderNsPerSprite << ',' << r.drawCalls << '\n';
+}
+
+int benchSprites(Context& ctx, std::size_t maxSprites)
+{
+    auto set = loadAnimationSet("media/walkingSprites.anim");
+    AtlasBuilder builder;
+    const auto handle = builder.addImage("media/walkingSprites.png");
+    if ( !set || !handle )
+        return -1;
+    auto atlas = builder.build(ctx);
+    if ( !atlas )
+        return -1;
+
+    std::vector<SpriteResult> results;
+    for(std::size_t sprites = 10; sprites <= maxSprites; sprites *= 10)
+    {
+        results.push_back(runSprites(ctx, atlas->region(*handle), *set, sprites));
+        std::cerr << "done " << sprites << " sprites" << std::endl;
+    }
+    printSpritesCSV(std::cout, results);
+    return 0;
+}
+
+struct ResidencyResult
+{
+    std::size_t budgetMB{0};
+    std::size_t textures{0};
+    int frames{0};
+    TextureResidency::Stats stats;
+    double frameMs{0};
+};
+
+// A large sprite set: every media image many times over, drawn through a window that slides by one texture per frame
+ResidencyResult runResidency(Context& ctx, std::size_t budgetMB, std::size_t textures, std::size_t window)
+{
+    ResidencyResult r;
+    r.budgetMB = budgetMB;
+    r.textures = textures;
+
+    const char* images[] = { "media/tree.png", "media/peace.png", "media/walkingSprites.png",
+        "media/circles4.png", "media/up.png", "media/default.png" };
+    TextureResidency residency(budgetMB << 20);
+    for(std::size_t i = 0; i < textures; i++)
+        residency.add(images[i % std::size(images)]);
+
+    r.frames = static_cast<int>(2 * textures);
+    const auto start = clock::now();
+    for(int frame = 0; frame < r.frames; frame++)
+    {
+        residency.beginFrame();
+        SDL_RenderClear( ctx.renderer() );
+        for(std::size_t i = 0; i < window; i++)
+        {
+            const auto id = static_cast<TextureResidency::Id>((frame + i) % textures);
+            const SDL_Rect dst{ static_cast<int>(i % 8) * 160, static_cast<int>(i / 8) * 160, 128, 128 };
+            residency.render(ctx, id, &dst);
+        }
+        SDL_RenderFlush( ctx.renderer() );
+    }
+    r.frameMs = std::chrono::duration<double, std::milli>(clock::now() - start).count() / r.frames;
+    r.stats = residency.stats();
+    return r;
+}
+
+int benchResidency(Context& ctx, std::size_t textures)
+{
+    const std::size_t window = 24;
+    std::vector<ResidencyResult> results;
+    // the first budget holds everything, the last one not even a full window
+    for(std::size_t budgetMB : {1024, 256, 64, 16})
+    {
+        results.push_back(runResidency(ctx, budgetMB, textures, window));
+        std::cerr << "done " << budgetMB << " MB" << std::endl;
+    }
+
+    std::cout << "budget_mb,textures,frames,hit_ratio,uploads,evictions,upload_ms,worst_upload_ms,peak_mb,frame_ms\n";
+    for(const ResidencyResult& r : results)
+        std::cout << r.budgetMB << ',' << r.textures << ',' << r.frames << ',' << r.stats.hitRatio() << ','
+                  << r.stats.misses << ',' << r.stats.evictions << ',' << r.stats.uploadMs << ','
+                  << r.stats.worstUploadMs << ',' << r.stats.peakBytes / double(1 << 20) << ',' << r.frameMs << '\n';
+    return 0;
+}
+
+// Offline: N looping voices over a synthetic chunk, mixed buffer after buffer without an audio device
+double runVoices(const MixKernels& kernels, std::size_t voices, int buffers)
+{
+    std::vector<Sint16> samples(mixerFrequency * mixerChannels);
+    for(std::size_t i = 0; i < samples.size(); i++)
+        samples[i] = static_cast<Sint16>((i * 7919) % 65536 - 32768);
+    Mix_Chunk chunk{};
+    chunk.abuf = reinterpret_cast<Uint8*>(samples.data());
+    chunk.alen = static_cast<Uint32>(samples.size() * sizeof(Sint16));
+
+    Mixer mixer(voices, kernels);
+    for(std::size_t i = 0; i < voices; i++)
+        mixer.play(&chunk, 1.0f / voices, 0, -1);
+
+    std::vector<Sint16> stream(static_cast<std::size_t>(mixerChunkSize) * mixerChannels);
+    for(int i = 0; i < buffers; i++)
+        mixer.mix(reinterpret_cast<Uint8*>(stream.data()), static_cast<int>(stream.size() * sizeof(Sint16)));
+    return mixer.stats().mixMs / buffers;
+}
+
+int benchVoices(std::size_t maxVoices)
+{
+    const int buffers = 200;
+    const double budgetMs = 1000.0 * mixerChunkSize / mixerFrequency;
+    std::cout << "kernels,voices,ms_per_buffer,budget_ms,ns_per_voice_sample\n";
+    for(const MixKernels* kernels : availableMixKernels())
+    {
+        for(std::size_t voices = 16; voices <= maxVoices; voices *= 4)
+        {
+            const double ms = runVoices(*kernels, voices, buffers);
+            std::cout << kernels->name << ',' << voices << ',' << ms << ',' << budgetMs << ','
+                      << ms * 1e6 / (voices * mixerChunkSize * mixerChannels) << '\n';
+        }
+        std::cerr << "done " << kernels->name << std::endl;
+    }
+    return 0;
+}
+
+// Empty zones back to back, recorded or not, against what a zone may cost
+int benchZones()
+{
+    const int zones = 4 * profileBufferEvents;
+    const double budgetNs = 50;
+    // the floor of a recorded zone, on VMs that trap rdtsc it is most of the cost
+    const auto clockStart = clock::now();
+    [[maybe_unused]] volatile std::uint64_t sink = 0;
+    for(int i = 0; i < zones; i++)
+        sink = profileTicks() + profileTicks();
+    const double clockNs = nanoseconds(clock::now() - clockStart) / zones;
+
+    std::cout << "recording,zones,ns_per_zone,two_clock_reads_ns,budget_ns,within_budget\n";
+    for(bool recording : {false, true})
+    {
+        if ( recording )
+            startProfiling();
+        const auto start = clock::now();
+        for(int i = 0; i < zones; i++)
+        {
+            PROFILE_ZONE("bench");
+        }
+        const double ns = nanoseconds(clock::now() - start) / zones;
+        std::cout << recording << ',' << zones << ',' << ns << ',' << clockNs << ',' << budgetNs << ','
+                  << (ns < budgetNs) << '\n';
+    }
+    stopProfiling();
+    return 0;
+}
+
+void printCSV(std::ostream& os, const std::vector<Result>& results)
+{
+    os << "balls,threads,collisions,construct_ms,update_ns_per_ball,render_submit_ns_per_ball,render_ns_per_ball,pairs_tested_per_step,draw_calls\n";
+    for(const Result& r : results)
+        os << r.balls << ',' << r.threads << ',' << r.collisions << ','
+           << r.constructMs << ',' << r.updateNsPerBall << ',' << r.submitNsPerBall << ','
+           << r.renderNsPerBall << ',' << r.pairsTestedPerStep << ',' << r.drawCalls << '\n';
+}
+
+void printJSON(std::ostream& os, const std::vector<Result>& results)
+{
+    os << "{\n  \"kernel\": \"" << integrateKernelName() << "\",\n  \"results\": [\n";
+    for(std::size_t i = 0; i < results.size(); i++)
+    {
+        const Result& r = results[i];
+        os << "    {\"balls\": " << r.balls
+           << ", \"threads\": " << r.threads
+           << ", \"collisions\": " << (r.collisions ? "true" : "false")
+           << ", \"construct_ms\": " << r.constructMs
+           << ", \"update_ns_per_ball\": " << r.updateNsPerBall
+           << ", \"render_submit_ns_per_ball\": " << r.submitNsPerBall
+           << ", \"render_ns_per_ball\": " << r.renderNsPerBall
+           << ", \"pairs_tested_per_step\": " << r.pairsTestedPerStep
+           << ", \"draw_calls\": " << r.drawCalls
+           << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    os << "  ]\n}\n";
+}
+
+void usage(const char* name)
+{
+    std::cerr << "Usage: " << name << " [--json] [--max BALLS] [--threads N] [--collisions] [--sprites] [--textures N] [--voices] [--zones]\n"
+              << "  Sweeps Scene sizes 10, 100, ... up to BALLS (default 1000000) on a headless software renderer.\n"
+              << "  Collisions are off unless --collisions is given: the scene is 1280x960 and large counts overlap completely.\n"
+              << "  --sprites sweeps animated walkers from media/walkingSprites.anim instead, as CSV.\n"
+              << "  --textures N draws N media textures through shrinking texture memory budgets instead, as CSV.\n"
+              << "  --voices mixes 16, 64, ... up to BALLS (capped at 1024) voices with every mixer kernel set instead, as CSV.\n"
+              << "  --zones measures what a profiler zone costs, recorded and not, instead, as CSV.\n";
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+    bool json = false;
+    bool collisions = false;
+    bool sprites = false;
+    bool voices = false;
+    bool zones = false;
+    std::size_t textures = 0;
+    std::size_t maxBalls = 1000000;
+    unsigned workers = JobSystem::defaultWorkerCount();
+
+    try
+    {
+        for(int i = 1; i < argc; i++)
+        {
+            const std::string arg = argv[i];
+            if ( "--json" == arg )
+                json = true;
+            else if ( "--collisions" == arg )
+                collisions = true;
+            else if ( "--sprites" == arg )
+                sprites = true;
+            else if ( "--voices" == arg )
+                voices = true;
+            else if ( "--zones" == arg )
+                zones = true;
+            else if ( "--textures" == arg && i + 1 < argc )
+                textures = std::stoul(argv[++i]);
+            else if ( "--max" == arg && i + 1 < argc )
+                maxBalls = std::stoul(argv[++i]);
+            else if ( "--threads" == arg && i + 1 < argc )
+                workers = std::max(1ul, std::stoul(argv[++i])) - 1;
+            else
+            {
+                usage(argv[0]);
+                return -1;
+            }
+        }
+    }
+    catch (const std::exception&)
+    {
+        usage(argv[0]);
+        return -1;
+    }
+
+    // no window or audio device needed; all plays of a run have to fit the mixer's command ring
+    if ( voices )
+        return benchVoices(std::min<std::size_t>(maxBalls, 1024));
+    if ( zones )
+        return benchZones();
+
+    auto contextOpt = createHeadlessContext(1280, 960);
+    if ( !contextOpt )
+        return -1;
+    auto context = std::move(contextOpt).value();
+
+    if ( textures > 0 )
+    {
+        const int rc = benchResidency(context, textures);
+        SDL_Quit();
+        return rc;
+    }
+
+    if ( sprites )
+    {
+        const int rc = benchSprites(context, maxBalls);
+        SDL_Quit();
+        return rc;
+    }
+
+    JobSystem jobs(workers);
+
+    std::vector<Result> results;
+    for(std::size_t balls = 10; balls <= maxBalls; balls *= 10)
+    {
+        results.push_back(run(context, &jobs, balls, collisions));
+        std::cerr << "done " << balls << " balls" << std::endl;
+    }
+
+    if ( json )
+        printJSON(std::cout, results);
+    else
+        printCSV(std::cout, results);
+
+    SDL_Quit();
+}
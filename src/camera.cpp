@@ -0,0 +1,35 @@
+#include <algorithm>
+
+#include "camera.hpp"
+
+Camera::Camera(int viewportWidth, int viewportHeight):
+    m_viewportWidth(viewportWidth), m_viewportHeight(viewportHeight),
+    m_centerX(viewportWidth / 2.0f), m_centerY(viewportHeight / 2.0f)
+{
+}
+
+void Camera::setZoom(float zoom) noexcept
+{
+    m_zoom = std::clamp(zoom, minZoom, maxZoom);
+}
+
+void Camera::pan(float screenDx, float screenDy) noexcept
+{
+    m_centerX += screenDx / m_zoom;
+    m_centerY += screenDy / m_zoom;
+}
+
+void Camera::zoomAt(float screenX, float screenY, float factor) noexcept
+{
+    const float worldX = toWorldX(screenX);
+    const float worldY = toWorldY(screenY);
+    setZoom(m_zoom * factor);
+    // shift so worldX/worldY map back to the same pixel
+    m_centerX += worldX - toWorldX(screenX);
+    m_centerY += worldY - toWorldY(screenY);
+}
+
+SDL_FRect Camera::visibleWorld() const noexcept
+{
+    return SDL_FRect{ left(), top(), m_viewportWidth / m_zoom, m_viewportHeight / m_zoom };
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <SDL.h>
+
+// Maps world coordinates to window pixels: screen = (world - topLeft) * zoom.
+class Camera
+{
+public:
+    // Starts as the identity mapping for a viewport of the given size
+    Camera(int viewportWidth, int viewportHeight);
+
+    int viewportWidth() const noexcept {return m_viewportWidth;}
+    int viewportHeight() const noexcept {return m_viewportHeight;}
+
+    float zoom() const noexcept {return m_zoom;}
+    void setZoom(float zoom) noexcept;
+
+    float centerX() const noexcept {return m_centerX;}
+    float centerY() const noexcept {return m_centerY;}
+    void lookAt(float x, float y) noexcept { m_centerX = x; m_centerY = y; }
+
+    // Moves the view by a distance given in screen pixels
+    void pan(float screenDx, float screenDy) noexcept;
+
+    // Zooms by factor keeping the world point under (screenX, screenY) in place
+    void zoomAt(float screenX, float screenY, float factor) noexcept;
+
+    float left() const noexcept {return m_centerX - m_viewportWidth / (2 * m_zoom);}
+    float top() const noexcept {return m_centerY - m_viewportHeight / (2 * m_zoom);}
+
+    float toScreenX(float x) const noexcept {return (x - left()) * m_zoom;}
+    float toScreenY(float y) const noexcept {return (y - top()) * m_zoom;}
+    float toWorldX(float x) const noexcept {return left() + x / m_zoom;}
+    float toWorldY(float y) const noexcept {return top() + y / m_zoom;}
+
+    // Part of the world that ends up in the viewport
+    SDL_FRect visibleWorld() const noexcept;
+
+    static constexpr float minZoom = 1.0f / 64;
+    static constexpr float maxZoom = 64.0f;
+
+private:
+    int m_viewportWidth{0};
+    int m_viewportHeight{0};
+    float m_centerX{0};
+    float m_centerY{0};
+    float m_zoom{1};
+};
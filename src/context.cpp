@@ -9,8 +9,10 @@
 #include <SDL_mixer.h>
 
 #include "context.hpp"
+#include "music.hpp"
+#include "profiler.hpp"
 
-std::unique_ptr<SDL_Window> initWindow(int width, int height)
+std::unique_ptr<SDL_Window> initWindow(int width, int height, Uint32 flags)
 {
     if (SDL_Init( SDL_INIT_VIDEO ) < 0 )
     {
@@ -24,7 +26,7 @@ std::unique_ptr<SDL_Window> initWindow(int width, int height)
             SDL_WINDOWPOS_UNDEFINED,
             width,
             height,
-            SDL_WINDOW_SHOWN );
+            flags );
         if ( NULL == window )
         {
             std::cerr << "Window could not be created! SDL_error: " << SDL_GetError() << std::endl;
@@ -35,10 +37,9 @@ std::unique_ptr<SDL_Window> initWindow(int width, int height)
     }
 }
 
-std::unique_ptr<SDL_Renderer> initRenderer(const std::unique_ptr<SDL_Window>& window)
+std::unique_ptr<SDL_Renderer> initRenderer(const std::unique_ptr<SDL_Window>& window, Uint32 flags)
 {
-    SDL_Renderer *renderer = SDL_CreateRenderer( window.get(), -1,
-            SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC );
+    SDL_Renderer *renderer = SDL_CreateRenderer( window.get(), -1, flags );
     if ( NULL == renderer )
     {
         std::cerr << "Renderer could not be created! SDL_error: " << SDL_GetError() << std::endl;
@@ -50,13 +51,14 @@ std::unique_ptr<SDL_Renderer> initRenderer(const std::unique_ptr<SDL_Window>& wi
     return std::unique_ptr<SDL_Renderer>(renderer);
 }
 
-std::optional<Context> createContext(int width, int height)
+std::optional<Context> createContext(int width, int height, const AudioProfile& audio)
 {
-    auto window = initWindow(width, height);
+    PROFILE_ZONE("createContext");
+    auto window = initWindow(width, height, SDL_WINDOW_SHOWN);
     if ( !window )
         return std::nullopt;
 
-    auto renderer = initRenderer(window);
+    auto renderer = initRenderer(window, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
     if ( !renderer )
         return std::nullopt;
 
@@ -73,11 +75,45 @@ std::optional<Context> createContext(int width, int height)
         return std::nullopt;
     }
 
-    if (Mix_OpenAudio( 44100, MIX_DEFAULT_FORMAT, 2, 2048) < 0 )
+    if (Mix_OpenAudio( audio.frequency, mixerFormat, mixerChannels, audio.chunkSize) < 0 )
     {
         std::cerr << "SDL_mixer could not be initialized! SDL_mixer Error: " << Mix_GetError() << std::endl;
         return std::nullopt;
     }
 
+    return Context(std::move(window), std::move(renderer), width, height, audio);
+}
+
+bool Context::reopenAudio(const AudioProfile& profile)
+{
+    Mix_CloseAudio();
+    if (Mix_OpenAudio( profile.frequency, mixerFormat, mixerChannels, profile.chunkSize) == 0 )
+    {
+        m_audio = profile;
+        return true;
+    }
+    std::cerr << "Unable to reopen audio with " << profile.chunkSize << " sample buffers! SDL_mixer Error: "
+              << Mix_GetError() << std::endl;
+
+    if ( m_audio && Mix_OpenAudio( m_audio->frequency, mixerFormat, mixerChannels, m_audio->chunkSize) < 0 )
+    {
+        std::cerr << "Audio is gone! SDL_mixer Error: " << Mix_GetError() << std::endl;
+        m_audio.reset();
+    }
+    return false;
+}
+
+std::optional<Context> createHeadlessContext(int width, int height)
+{
+    SDL_SetHint( SDL_HINT_VIDEODRIVER, "dummy" );
+
+    auto window = initWindow(width, height, SDL_WINDOW_HIDDEN);
+    if ( !window )
+        return std::nullopt;
+
+    auto renderer = initRenderer(window, SDL_RENDERER_SOFTWARE);
+    if ( !renderer )
+        return std::nullopt;
+
     return Context(std::move(window), std::move(renderer), width, height);
 }
@@ -4,6 +4,8 @@
 
 #include <SDL.h>
 
+#include "music.hpp"
+
 template<>
 class std::default_delete<SDL_Window>
 {
@@ -28,21 +30,34 @@ class Context
 {
 public:
     explicit Context(std::unique_ptr<SDL_Window>&& window, std::unique_ptr<SDL_Renderer>&& renderer,
-        int width, int height):
+        int width, int height, std::optional<AudioProfile> audio = std::nullopt):
         m_window(std::move(window)), m_renderer(std::move(renderer)),
-        m_width(width), m_height(height) {}
+        m_width(width), m_height(height), m_audio(audio) {}
 
     SDL_Renderer* renderer() noexcept { return m_renderer.get(); }
 
     int width() const noexcept {return m_width;}
     int height() const noexcept {return m_height;}
 
+    // What the mixer device is open with, nothing without audio
+    const std::optional<AudioProfile>& audio() const noexcept {return m_audio;}
+
+    // Closes the mixer device and opens it again, e.g. with a larger buffer after underruns. Channels and music
+    // playing through SDL_mixer stop, loaded chunks and music stay usable. If the profile can't be opened the
+    // previous one is restored and false returned.
+    bool reopenAudio(const AudioProfile& profile);
+
 protected:
     std::unique_ptr<SDL_Window> m_window;
     std::unique_ptr<SDL_Renderer> m_renderer;
     int m_width{0};
     int m_height{0};
+    std::optional<AudioProfile> m_audio;
 };
 
 
-std::optional<Context> createContext(int widht, int height);
+std::optional<Context> createContext(int widht, int height, const AudioProfile& audio = defaultAudioProfile);
+
+// Window on SDL's dummy video driver with a software renderer, no image/font/audio subsystems.
+// Used for benchmarks on machines without a display.
+std::optional<Context> createHeadlessContext(int width, int height);
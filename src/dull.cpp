@@ -3,6 +3,7 @@
 #include <filesystem>
 #include <optional>
 #include <cassert>
+#include <chrono>
 
 #include <SDL.h>
 #include <SDL_image.h>
@@ -10,6 +11,13 @@
 
 #include "context.hpp"
 #include "texture.hpp"
+#include "atlas.hpp"
+#include "animation.hpp"
+#include "glyph_atlas.hpp"
+#include "assets.hpp"
+#include "asset_pack.hpp"
+#include "hot_reload.hpp"
+#include "job_system.hpp"
 #include "surface.hpp"
 #include "font.hpp"
 
@@ -34,8 +42,8 @@ void renderGeometry(Context& ctx, int width, int height)
 }
 
 void renderBackground(Context& ctx,
-    Texture& landscapeImage,
-    Texture& peaceImage,
+    TextureRegion& landscapeImage,
+    TextureRegion& peaceImage,
     const SDL_Rect& wholeViewport,
     std::uint8_t rComponent, std::uint8_t gComponent, std::uint8_t bComponent)
 {
@@ -58,10 +66,11 @@ void renderBackground(Context& ctx,
     //SDL_RenderClear( renderer.get() );
     SDL_RenderSetViewport( ctx.renderer(), &wholeViewport);
     landscapeImage.setColorMod( rComponent, gComponent, bComponent );
-    SDL_RenderCopy( ctx.renderer(), landscapeImage.texture(), NULL, NULL );
+    landscapeImage.render( ctx, NULL );
+    landscapeImage.setColorMod( 0xFF, 0xFF, 0xFF );
 
     SDL_RenderSetViewport( ctx.renderer(), &topLeftViewport);
-    SDL_RenderCopy( ctx.renderer(), peaceImage.texture(), NULL, NULL );
+    peaceImage.render( ctx, NULL );
 
     SDL_RenderSetViewport( ctx.renderer(), &bottomViewport);
     renderGeometry( ctx, bottomViewport.w, bottomViewport.h);
@@ -78,46 +87,71 @@ int main()
         return -1;
     auto context = std::move(contextOpt).value();
 
-    auto peaceImageOpt = loadTexture("media/peace.png", context);
-    if ( !peaceImageOpt )
+    // every image goes into one atlas so the frame binds a single texture for all of them
+    AssetCache assets;
+    if ( std::filesystem::exists("media.pack") )
+        assets.mount(openAssetPack("media.pack"));
+    AtlasBuilder atlasBuilder;
+    auto peaceSurface = assets.image("media/peace.png");
+    if ( !peaceSurface )
         return -1;
-    auto peaceImage = std::move(peaceImageOpt).value();
+    const auto peaceHandle = atlasBuilder.add(peaceSurface);
 
-    auto upImageOpt = loadTexture("media/up.png", context);
-    if ( !upImageOpt )
+    auto upSurface = assets.image("media/up.png");
+    if ( !upSurface )
         return -1;
-    auto upImage = std::move(upImageOpt).value();
+    const auto upHandle = atlasBuilder.add(upSurface);
 
-    auto defaultImageOpt = loadTexture("media/default.png", context);
-    if ( !defaultImageOpt )
+    auto defaultSurface = assets.image("media/default.png");
+    if ( !defaultSurface )
         return -1;
-    auto defaultImage = std::move(defaultImageOpt).value();
+    const auto defaultHandle = atlasBuilder.add(defaultSurface);
 
-    auto landscapeImageOpt = loadTexture("media/tree.png", context);
-    if ( !landscapeImageOpt )
+    auto landscapeSurface = assets.image("media/tree.png");
+    if ( !landscapeSurface )
         return -1;
-    auto landscapeImage = std::move(landscapeImageOpt).value();
+    const auto landscapeHandle = atlasBuilder.add(landscapeSurface);
 
-    auto circlesImageOpt = loadTexture("media/circles4.png", context);
-    if ( !circlesImageOpt )
+    auto circlesSurface = assets.image("media/circles4.png");
+    if ( !circlesSurface )
         return -1;
-    auto circlesImage = std::move(circlesImageOpt).value();
-    circlesImage.setBlendMode(SDL_BLENDMODE_BLEND);
+    const auto circlesHandle = atlasBuilder.add(circlesSurface);
 
-    auto walkingSpritesOpt = loadTexture("media/walkingSprites.png", context);
-    if ( !walkingSpritesOpt )
+    auto walkingSpritesSurface = assets.image("media/walkingSprites.png");
+    if ( !walkingSpritesSurface )
         return -1;
-    auto walkingSprites = std::move(walkingSpritesOpt).value();
+    const auto walkingSpritesHandle = atlasBuilder.add(walkingSpritesSurface);
 
-    auto font = loadFont("media/lazy.ttf");
-    if ( !font )
+    auto atlasOpt = atlasBuilder.build(context);
+    if ( !atlasOpt )
         return -1;
+    auto atlas = std::move(atlasOpt).value();
+
+    auto peaceImage = atlas.region(peaceHandle);
+    auto upImage = atlas.region(upHandle);
+    auto defaultImage = atlas.region(defaultHandle);
+    auto landscapeImage = atlas.region(landscapeHandle);
+    auto circlesImage = atlas.region(circlesHandle);
+    auto walkingSprites = atlas.region(walkingSpritesHandle);
 
-    SDL_Color textColor = {0, 0, 0};
-    auto textTextureOpt = textureFromText(context, "The quick brown fox jumps over the lazy dogs, ну типа..", font, textColor);
-    if ( !textTextureOpt )
+    auto font = assets.font("media/lazy.ttf");
+    if ( !font )
         return -1;
-    auto textTexture =std::move(textTextureOpt).value();
+
+    // the glyphs follow the font if it is reloaded
+    GlyphAtlas glyphs(font);
+    const SDL_Color textColor = {0, 0, 0, 0xFF};
+    const std::string text = "The quick brown fox jumps over the lazy dogs, ну типа..";
+
+    // one worker is plenty for decoding the odd changed file
+    JobSystem jobs(1);
+    HotReloader reloader(assets, jobs);
+    const std::pair<const char*, TextureAtlas::Handle> atlasImages[] = {
+        {"media/peace.png", peaceHandle}, {"media/up.png", upHandle}, {"media/default.png", defaultHandle},
+        {"media/tree.png", landscapeHandle}, {"media/circles4.png", circlesHandle},
+        {"media/walkingSprites.png", walkingSpritesHandle} };
+    for(const auto& [path, handle] : atlasImages)
+        reloader.onImageReload(path, [&atlas, handle = handle](SDL_Surface& image) { atlas.update(handle, &image); });
 
     SDL_Rect wholeViewport {
         .x = 0,
@@ -134,16 +168,20 @@ int main()
             clips[i*2 + j] = {.x = i*128, .y = j*128, .w = 128, .h = 128 };
 
 
-    std::array<SDL_Rect, 4> spriteClips;
-    spriteClips[0] = {.x = 10, .y = 0,  .w = 108, .h = 128 };
-    spriteClips[1] = {.x = 138, .y = 0, .w = 108, .h = 128 };
-    spriteClips[2] = {.x = 266, .y = 0, .w = 108, .h = 128 };
-    spriteClips[3] = {.x = 394, .y = 0, .w = 108, .h = 128 };
+    auto walking = loadAnimationSet("media/walkingSprites.anim");
+    if ( !walking )
+        return -1;
+    const auto walk = walking->find("walk");
+    if ( !walk )
+        return -1;
+    SpriteAnimator animator;
+    const auto walkingSheet = animator.addSheet(*walking, walkingSprites);
+    animator.add(walkingSheet, *walk, SDL_FRect{ SCREEN_WIDTH / 2.0f - 64, SCREEN_HEIGHT / 2.0f - 64, 128, 128 });
 
     SDL_Rect renderQuad = { .x = 832, .y = 192, .w = 256, .h = 256 };
 
     SDL_Event e;
-    std::uint32_t iFrame = 0;
+    auto lastFrame = std::chrono::steady_clock::now();
     bool quit = false;
     std::uint8_t rComponent = 0xFF;
     std::uint8_t gComponent = 0xFF;
@@ -152,6 +190,12 @@ int main()
     ArrowState arrowState { ArrowState::Default };
     while ( !quit )
     {
+        const auto now = std::chrono::steady_clock::now();
+        animator.update(std::chrono::duration<float>(now - lastFrame).count());
+        lastFrame = now;
+
+        reloader.poll(context);
+
         while ( SDL_PollEvent( &e ) )
          {
               if ( SDL_QUIT == e.type )
@@ -228,19 +272,19 @@ int main()
             switch (arrowState)
             {
                 case ArrowState::Up:
-                    SDL_RenderCopy( context.renderer(), upImage.texture(), NULL, &renderQuad);
+                    upImage.render( context, &renderQuad );
                     break;
                 case ArrowState::Down:
-                    SDL_RenderCopyEx( context.renderer(), upImage.texture(), NULL, &renderQuad, 180, NULL, SDL_FLIP_NONE);
+                    upImage.render( context, &renderQuad, NULL, 180 );
                     break;
                 case ArrowState::Left:
-                    SDL_RenderCopyEx( context.renderer(), upImage.texture(), NULL, &renderQuad, 270, NULL, SDL_FLIP_NONE);
+                    upImage.render( context, &renderQuad, NULL, 270 );
                     break;
                  case ArrowState::Right:
-                    SDL_RenderCopyEx( context.renderer(), upImage.texture(), NULL, &renderQuad, 90, NULL, SDL_FLIP_NONE);
+                    upImage.render( context, &renderQuad, NULL, 90 );
                     break;
                 case ArrowState::Default:
-                    SDL_RenderCopy( context.renderer(), defaultImage.texture(), NULL, &renderQuad);
+                    defaultImage.render( context, &renderQuad );
                     break;
            }
 
@@ -249,24 +293,18 @@ int main()
                 for(int j = 0; j < 2; j++)
                     rects[i*2 +j] = { .x = 160 + 320*(i*2 + j), .y = 820, .w = 128, .h = 128 };
 
-            SDL_SetTextureAlphaMod( circlesImage.texture(), aComponent );
+            circlesImage.setAlphaMod( aComponent );
             for(int i = 0; i < 4; i++)
-                SDL_RenderCopy( context.renderer(), circlesImage.texture(), &clips[i], &rects[i]);
+                circlesImage.render( context, &rects[i], &clips[i] );
+            circlesImage.setAlphaMod( 0xFF );
 
            SDL_RenderSetViewport( context.renderer(), &wholeViewport);
-            const auto iClip = ( iFrame / 4 ) % 4;
-            SDL_Rect walkingRect = {.x = SCREEN_WIDTH / 2 - 64, .y = SCREEN_HEIGHT / 2 - 64, .w = 128, .h = 128};
-            SDL_RenderCopy( context.renderer(), walkingSprites.texture(), &spriteClips[iClip], &walkingRect );
+            animator.render( context );
 
-            SDL_Rect rText { .x = ( SCREEN_WIDTH - textTexture.width() ) / 2,
-                                         .y = (SCREEN_HEIGHT - textTexture.height() ) / 2,
-                                         .w = textTexture.width(),
-                                         .h = textTexture.height()
-                                       };
-            SDL_RenderCopy( context.renderer(), textTexture.texture(), NULL, &rText);
+            const SDL_Point textSize = glyphs.measure( text );
+            glyphs.render( context, text, ( SCREEN_WIDTH - textSize.x ) / 2.0f, ( SCREEN_HEIGHT - textSize.y ) / 2.0f, textColor );
 
             SDL_RenderPresent( context.renderer() );
-            iFrame++;
         }
     }
 
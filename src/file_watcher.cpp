@@ -0,0 +1,114 @@
+#include <iostream>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#include "file_watcher.hpp"
+
+namespace
+{
+    std::filesystem::path normalized(const std::filesystem::path& path)
+    {
+        return path.lexically_normal();
+    }
+}
+
+#ifdef __linux__
+
+FileWatcher::FileWatcher()
+{
+    m_fd = inotify_init1( IN_NONBLOCK | IN_CLOEXEC );
+    if ( -1 == m_fd )
+        std::cerr << "Unable to watch files: " << std::strerror(errno) << std::endl;
+}
+
+FileWatcher::~FileWatcher()
+{
+    if ( -1 != m_fd )
+        close( m_fd );
+}
+
+bool FileWatcher::watch(const std::filesystem::path& file)
+{
+    if ( -1 == m_fd )
+        return false;
+
+    const auto path = normalized(file);
+    if ( m_files.count(path) )
+        return true;
+
+    const auto directory = path.has_parent_path() ? path.parent_path() : std::filesystem::path(".");
+    const bool known = std::any_of(m_directories.begin(), m_directories.end(),
+        [&](const auto& d) { return d.second == directory; });
+    if ( !known )
+    {
+        const int wd = inotify_add_watch( m_fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO );
+        if ( -1 == wd )
+        {
+            std::cerr << "Unable to watch " << directory << ": " << std::strerror(errno) << std::endl;
+            return false;
+        }
+        m_directories[wd] = directory;
+    }
+
+    m_files.insert(path);
+    return true;
+}
+
+std::vector<std::filesystem::path> FileWatcher::changes()
+{
+    std::vector<std::filesystem::path> changed;
+    if ( -1 == m_fd )
+        return changed;
+
+    alignas(inotify_event) char buffer[4096];
+    for(;;)
+    {
+        const ssize_t length = read( m_fd, buffer, sizeof(buffer) );
+        if ( length <= 0 )
+            break;
+
+        for(ssize_t offset = 0; offset < length; )
+        {
+            const auto* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+            offset += sizeof(inotify_event) + event->len;
+
+            auto directory = m_directories.find(event->wd);
+            if ( 0 == event->len || directory == m_directories.end() )
+                continue;
+
+            const auto path = normalized(directory->second / event->name);
+            if ( m_files.count(path) && std::find(changed.begin(), changed.end(), path) == changed.end() )
+                changed.push_back(path);
+        }
+    }
+    return changed;
+}
+
+#else
+
+FileWatcher::FileWatcher() = default;
+FileWatcher::~FileWatcher() = default;
+
+bool FileWatcher::watch(const std::filesystem::path& file)
+{
+    m_files.insert(normalized(file));
+    return false;
+}
+
+std::vector<std::filesystem::path> FileWatcher::changes()
+{
+    return {};
+}
+
+#endif
+
+bool FileWatcher::watching(const std::filesystem::path& file) const
+{
+    return m_files.count(normalized(file)) > 0;
+}
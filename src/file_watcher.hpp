@@ -0,0 +1,30 @@
+#pragma once
+
+#include <filesystem>
+#include <map>
+#include <set>
+#include <vector>
+
+// Notices files being written or replaced, using inotify on Linux.
+// Elsewhere nothing is ever reported.
+class FileWatcher
+{
+public:
+    FileWatcher();
+    ~FileWatcher();
+
+    FileWatcher(const FileWatcher&) = delete;
+    FileWatcher& operator=(const FileWatcher&) = delete;
+
+    // Watches the file's directory, so files replaced by a rename (as most editors save) are noticed too
+    bool watch(const std::filesystem::path& file);
+    bool watching(const std::filesystem::path& file) const;
+
+    // Watched files written or replaced since the last call, each once; never blocks
+    std::vector<std::filesystem::path> changes();
+
+private:
+    int m_fd{-1};
+    std::map<int, std::filesystem::path> m_directories;  // watch descriptor -> directory
+    std::set<std::filesystem::path> m_files;
+};
@@ -0,0 +1,37 @@
+#include <cassert>
+
+#include "fixed_timestep.hpp"
+
+FixedTimestep::FixedTimestep(double ticksPerSecond, int maxTicksPerFrame):
+    m_ticksPerSecond(ticksPerSecond),
+    m_maxTicksPerFrame(maxTicksPerFrame),
+    m_step(std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(1.0 / ticksPerSecond)))
+{
+    assert( ticksPerSecond > 0 );
+    assert( maxTicksPerFrame > 0 );
+}
+
+int FixedTimestep::advance(clock::duration frameTime)
+{
+    m_accumulator += frameTime;
+
+    int ticks = 0;
+    while ( m_accumulator >= m_step && ticks < m_maxTicksPerFrame )
+    {
+        m_accumulator -= m_step;
+        ticks++;
+    }
+
+    if ( m_accumulator >= m_step )
+    {
+        m_droppedTicks += m_accumulator / m_step;
+        m_accumulator %= m_step;
+    }
+
+    return ticks;
+}
+
+float FixedTimestep::alpha() const noexcept
+{
+    return std::chrono::duration<float>(m_accumulator) / std::chrono::duration<float>(m_step);
+}
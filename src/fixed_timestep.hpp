@@ -0,0 +1,35 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+// Accumulates real frame time and turns it into a whole number of fixed simulation ticks.
+// Catch-up is capped so a long frame can't make the next one even longer;
+// the time that doesn't fit is dropped and the simulation just runs slower for a moment.
+class FixedTimestep
+{
+public:
+    using clock = std::chrono::steady_clock;
+
+    explicit FixedTimestep(double ticksPerSecond, int maxTicksPerFrame = 5);
+
+    // Adds frameTime to the accumulator and returns how many ticks to simulate now
+    int advance(clock::duration frameTime);
+
+    clock::duration step() const noexcept {return m_step;}
+    float stepSeconds() const noexcept {return std::chrono::duration<float>(m_step).count();}
+
+    // How far we are between the previous and the current tick, in [0, 1)
+    float alpha() const noexcept;
+
+    double ticksPerSecond() const noexcept {return m_ticksPerSecond;}
+    int maxTicksPerFrame() const noexcept {return m_maxTicksPerFrame;}
+    std::uint64_t droppedTicks() const noexcept {return m_droppedTicks;}
+
+private:
+    double m_ticksPerSecond{0};
+    int m_maxTicksPerFrame{0};
+    clock::duration m_step{0};
+    clock::duration m_accumulator{0};
+    std::uint64_t m_droppedTicks{0};
+};
@@ -1,18 +1,33 @@
+#include <atomic>
 #include <iostream>
 #include <memory>
 #include <filesystem>
+#include <mutex>
 
 #include <SDL.h>
 #include <SDL_ttf.h>
 
 #include "font.hpp"
+#include "profiler.hpp"
 
-std::unique_ptr<TTF_Font> loadFont(const std::filesystem::path& path)
+Font::Font(std::unique_ptr<TTF_Font>&& font) noexcept: m_font(std::move(font))
 {
-    TTF_Font *font = TTF_OpenFont( path.c_str(), 28);
+    static std::atomic<std::uint64_t> generations{0};
+    if ( m_font )
+        m_generation = generations.fetch_add(1, std::memory_order_relaxed) + 1;
+}
+
+std::unique_ptr<TTF_Font> loadFont(const std::filesystem::path& path, int pointSize)
+{
+    PROFILE_ZONE("loadFont");
+    // SDL_ttf shares one FreeType library between all fonts, opening faces on it isn't thread safe
+    static std::mutex openMutex;
+    std::lock_guard lock(openMutex);
+
+    TTF_Font *font = TTF_OpenFont( path.c_str(), pointSize);
     if ( NULL == font )
     {
-        std::cerr << "Failed to load lazy font! SDL_ttf Error: " << TTF_GetError() << std::endl;
+        std::cerr << "Failed to load font from " << path << "! SDL_ttf Error: " << TTF_GetError() << std::endl;
         return nullptr;
     }
 
@@ -1,6 +1,10 @@
+#pragma once
+
+#include <cstdint>
 #include <iostream>
 #include <memory>
 #include <filesystem>
+#include <utility>
 
 #include <SDL.h>
 #include <SDL_ttf.h>
@@ -16,6 +20,34 @@ public:
 };
 
 
-std::unique_ptr<TTF_Font> loadFont(const std::filesystem::path& path);
+constexpr int defaultFontSize = 28;
+
+std::unique_ptr<TTF_Font> loadFont(const std::filesystem::path& path, int pointSize = defaultFontSize);
+
+// An open font and its generation. Every font opened gets a new one, so whatever keeps glyphs or text rendered
+// with a font can tell a reloaded font apart, even when SDL_ttf hands out the address of the old one again.
+class Font
+{
+public:
+    Font() = default;
+    Font(std::unique_ptr<TTF_Font>&& font) noexcept;
+    explicit Font(TTF_Font* font) noexcept: Font(std::unique_ptr<TTF_Font>(font)) {}
+
+    Font(Font&& other) noexcept:
+        m_font(std::move(other.m_font)), m_generation(std::exchange(other.m_generation, 0)) {}
+    Font& operator=(Font&& other) noexcept
+    {
+        m_font = std::move(other.m_font);
+        m_generation = std::exchange(other.m_generation, 0);
+        return *this;
+    }
+
+    TTF_Font* get() const noexcept {return m_font.get();}
+    explicit operator bool() const noexcept {return static_cast<bool>(m_font);}
+    // 0 without a font
+    std::uint64_t generation() const noexcept {return m_generation;}
 
-using Font = std::unique_ptr<TTF_Font>;
+private:
+    std::unique_ptr<TTF_Font> m_font;
+    std::uint64_t m_generation{0};
+};
@@ -0,0 +1,185 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <iomanip>
+
+#include "frame_timing.hpp"
+
+namespace
+{
+    double milliseconds(std::uint64_t ns)
+    {
+        return ns / 1e6;
+    }
+
+    std::uint64_t nanoseconds(FrameTiming::clock::duration d)
+    {
+        return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(d).count());
+    }
+}
+
+std::size_t TimeHistogram::bucketOf(std::uint64_t ns) noexcept
+{
+    if ( ns < subBuckets )
+        return static_cast<std::size_t>(ns);
+    const int msb = 63 - __builtin_clzll(ns);
+    if ( msb >= maxBits )
+        return bucketCount - 1;
+    // the top bit is implied by the shift, the next subBucketBits pick the bucket within the power of two
+    const int shift = msb - subBucketBits;
+    return static_cast<std::size_t>(shift + 1) * subBuckets + ((ns >> shift) - subBuckets);
+}
+
+std::uint64_t TimeHistogram::valueOf(std::size_t bucket) noexcept
+{
+    if ( bucket < subBuckets )
+        return bucket;
+    const int shift = static_cast<int>(bucket / subBuckets) - 1;
+    const std::uint64_t low = (subBuckets + bucket % subBuckets) << shift;
+    return low + ((std::uint64_t(1) << shift) >> 1);
+}
+
+void TimeHistogram::record(std::uint64_t ns) noexcept
+{
+    m_counts[bucketOf(ns)]++;
+    m_count++;
+    m_sum += ns;
+    m_max = std::max(m_max, ns);
+}
+
+void TimeHistogram::reset() noexcept
+{
+    m_counts.fill(0);
+    m_count = 0;
+    m_sum = 0;
+    m_max = 0;
+}
+
+std::uint64_t TimeHistogram::percentile(double p) const noexcept
+{
+    if ( 0 == m_count )
+        return 0;
+    const auto target = std::max<std::uint64_t>(1, static_cast<std::uint64_t>(std::ceil(p / 100.0 * m_count)));
+    std::uint64_t seen = 0;
+    for(std::size_t bucket = 0; bucket < bucketCount; bucket++)
+    {
+        seen += m_counts[bucket];
+        if ( seen >= target )
+            return std::min(valueOf(bucket), m_max);
+    }
+    return m_max;
+}
+
+const char* FrameTiming::name(Phase phase) noexcept
+{
+    switch (phase)
+    {
+        case Phase::Reload: return "reload";
+        case Phase::Events: return "events";
+        case Phase::Keyboard: return "keyboard";
+        case Phase::Handling: return "handling";
+        case Phase::Update: return "update";
+        case Phase::Clear: return "clear";
+        case Phase::Buttons: return "buttons";
+        case Phase::Info: return "info";
+        case Phase::Arrow: return "arrow";
+        case Phase::Scene: return "scene";
+        case Phase::Present: return "present";
+        case Phase::Frame: return "frame";
+    }
+    return "?";
+}
+
+FrameTiming::FrameTiming(clock::duration window): m_windowLength(window)
+{
+    m_windowStart = m_frameStart = m_last = clock::now();
+}
+
+void FrameTiming::beginFrame() noexcept
+{
+    m_frameStart = m_last = clock::now();
+}
+
+void FrameTiming::lap(Phase phase) noexcept
+{
+    const auto now = clock::now();
+    const std::uint64_t ns = nanoseconds(now - m_last);
+    m_total[static_cast<std::size_t>(phase)].record(ns);
+    m_current[static_cast<std::size_t>(phase)].record(ns);
+    m_last = now;
+}
+
+bool FrameTiming::endFrame() noexcept
+{
+    const auto now = clock::now();
+    const std::uint64_t ns = nanoseconds(now - m_frameStart);
+    m_total[static_cast<std::size_t>(Phase::Frame)].record(ns);
+    m_current[static_cast<std::size_t>(Phase::Frame)].record(ns);
+    m_windowFrames++;
+
+    if ( now - m_windowStart < m_windowLength )
+        return false;
+
+    m_fps = m_windowFrames / std::chrono::duration<double>(now - m_windowStart).count();
+    m_window = m_current;
+    for(TimeHistogram& histogram : m_current)
+        histogram.reset();
+    m_windowFrames = 0;
+    m_windowStart = now;
+    return true;
+}
+
+void FrameTiming::format(char* text, std::size_t size, bool whole) const noexcept
+{
+    const auto& histograms = whole ? m_total : m_window;
+    const TimeHistogram& frame = histograms[static_cast<std::size_t>(Phase::Frame)];
+
+    std::size_t worst = 0;
+    std::uint64_t worstP99 = 0;
+    for(std::size_t i = 0; i < static_cast<std::size_t>(Phase::Frame); i++)
+    {
+        const std::uint64_t p99 = histograms[i].percentile(99);
+        if ( p99 > worstP99 )
+        {
+            worst = i;
+            worstP99 = p99;
+        }
+    }
+
+    std::snprintf(text, size, "frame p50 %.2f p99 %.2f ms, worst %s p99 %.2f ms",
+        milliseconds(frame.percentile(50)), milliseconds(frame.percentile(99)), name(static_cast<Phase>(worst)),
+        milliseconds(worstP99));
+}
+
+void FrameTiming::formatTable(char* text, std::size_t size, bool whole) const noexcept
+{
+    const auto& histograms = whole ? m_total : m_window;
+
+    int used = std::snprintf(text, size, "%-10s %8s %8s %8s %8s ms", "phase", "p50", "p95", "p99", "max");
+    for(std::size_t i = 0; i < phaseCount && used >= 0 && static_cast<std::size_t>(used) < size; i++)
+    {
+        const TimeHistogram& h = histograms[i];
+        const int line = std::snprintf(text + used, size - used, "\n%-10s %8.2f %8.2f %8.2f %8.2f",
+            name(static_cast<Phase>(i)), milliseconds(h.percentile(50)), milliseconds(h.percentile(95)),
+            milliseconds(h.percentile(99)), milliseconds(h.max()));
+        used = line < 0 ? line : used + line;
+    }
+}
+
+void FrameTiming::dump(std::ostream& os) const
+{
+    os << "Frame timing over " << total(Phase::Frame).count() << " frames, in ms:\n"
+       << std::left << std::setw(10) << "phase" << std::right
+       << std::setw(10) << "mean" << std::setw(10) << "p50" << std::setw(10) << "p95"
+       << std::setw(10) << "p99" << std::setw(10) << "max" << '\n'
+       << std::fixed << std::setprecision(3);
+    for(std::size_t i = 0; i < phaseCount; i++)
+    {
+        const TimeHistogram& h = m_total[i];
+        os << std::left << std::setw(10) << name(static_cast<Phase>(i)) << std::right
+           << std::setw(10) << h.mean() / 1e6 << std::setw(10) << milliseconds(h.percentile(50))
+           << std::setw(10) << milliseconds(h.percentile(95)) << std::setw(10) << milliseconds(h.percentile(99))
+           << std::setw(10) << milliseconds(h.max()) << '\n';
+    }
+    os << std::defaultfloat << std::setprecision(6) << std::flush;
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+// Nanosecond durations in log-linear buckets, like an HDR histogram: every power of two is split into
+// 32 equal buckets, so any recorded value is known within about 3% from 1 ns up to minutes, in fixed memory.
+class TimeHistogram
+{
+public:
+    void record(std::uint64_t ns) noexcept;
+    void reset() noexcept;
+
+    std::uint64_t count() const noexcept {return m_count;}
+    std::uint64_t max() const noexcept {return m_max;}
+    double mean() const noexcept {return m_count ? double(m_sum) / m_count : 0.0;}
+    // Smallest recorded value at or above which lie (100 - p)% of the values, within the bucket precision
+    std::uint64_t percentile(double p) const noexcept;
+
+private:
+    static constexpr int subBucketBits = 5;
+    static constexpr int subBuckets = 1 << subBucketBits;
+    // 2^40 ns is over 18 minutes, longer durations land in the last bucket
+    static constexpr int maxBits = 40;
+    static constexpr std::size_t bucketCount = (maxBits - subBucketBits + 1) * subBuckets;
+
+    static std::size_t bucketOf(std::uint64_t ns) noexcept;
+    // Middle of the bucket's range
+    static std::uint64_t valueOf(std::size_t bucket) noexcept;
+
+    std::array<std::uint32_t, bucketCount> m_counts{};
+    std::uint64_t m_count{0};
+    std::uint64_t m_sum{0};
+    std::uint64_t m_max{0};
+};
+
+// Times each phase of a frame with one clock read per phase: lap(phase) ends the phase and starts the next one.
+// Every phase keeps a histogram over the whole run and one over the current window, e.g. for an overlay.
+class FrameTiming
+{
+public:
+    using clock = std::chrono::steady_clock;
+
+    enum class Phase { Reload, Events, Keyboard, Handling, Update, Clear, Buttons, Info, Arrow, Scene, Present, Frame };
+    static constexpr std::size_t phaseCount = static_cast<std::size_t>(Phase::Frame) + 1;
+    static const char* name(Phase phase) noexcept;
+
+    explicit FrameTiming(clock::duration window = std::chrono::seconds(1));
+
+    void beginFrame() noexcept;
+    void lap(Phase phase) noexcept;
+    // Records the whole frame; true when that closed a window, whose histograms stay readable until the next one
+    bool endFrame() noexcept;
+
+    const TimeHistogram& total(Phase phase) const noexcept {return m_total[static_cast<std::size_t>(phase)];}
+    const TimeHistogram& window(Phase phase) const noexcept {return m_window[static_cast<std::size_t>(phase)];}
+    // Frames per second over the last closed window
+    double fps() const noexcept {return m_fps;}
+
+    // One line for an overlay, from the window or the whole run: frame p50 and p99, and the phase with the worst p99
+    void format(char* text, std::size_t size, bool whole) const noexcept;
+    // The same as a table for an overlay, one phase per line with its p50, p95, p99 and max
+    void formatTable(char* text, std::size_t size, bool whole) const noexcept;
+    // Table of the whole run, for the end of the program
+    void dump(std::ostream& os) const;
+
+private:
+    clock::duration m_windowLength;
+    clock::time_point m_windowStart;
+    clock::time_point m_frameStart;
+    clock::time_point m_last;
+    std::array<TimeHistogram, phaseCount> m_total;
+    std::array<TimeHistogram, phaseCount> m_window;
+    // the window being filled, m_window holds the last closed one
+    std::array<TimeHistogram, phaseCount> m_current;
+    std::uint64_t m_windowFrames{0};
+    double m_fps{0};
+};
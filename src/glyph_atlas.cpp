@@ -0,0 +1,229 @@
+#include <iostream>
+#include <algorithm>
+#include <optional>
+
+#include "glyph_atlas.hpp"
+#include "pixel_convert.hpp"
+
+namespace
+{
+    const char32_t replacementCharacter = 0xFFFD;
+
+    // Decodes the code point starting at text[i] and moves i past it; malformed sequences give U+FFFD
+    char32_t nextCodepoint(std::string_view text, std::size_t& i)
+    {
+        const auto lead = static_cast<unsigned char>(text[i++]);
+        if ( lead < 0x80 )
+            return lead;
+
+        int length = 0;
+        char32_t codepoint = 0;
+        if ( (lead & 0xE0) == 0xC0 )
+        {
+            length = 1;
+            codepoint = lead & 0x1F;
+        }
+        else if ( (lead & 0xF0) == 0xE0 )
+        {
+            length = 2;
+            codepoint = lead & 0x0F;
+        }
+        else if ( (lead & 0xF8) == 0xF0 )
+        {
+            length = 3;
+            codepoint = lead & 0x07;
+        }
+        else
+            return replacementCharacter;
+
+        for(int k = 0; k < length; k++)
+        {
+            if ( i >= text.size() || (static_cast<unsigned char>(text[i]) & 0xC0) != 0x80 )
+                return replacementCharacter;
+            codepoint = (codepoint << 6) | (static_cast<unsigned char>(text[i++]) & 0x3F);
+        }
+        return codepoint <= 0x10FFFF ? codepoint : replacementCharacter;
+    }
+}
+
+GlyphAtlas::GlyphAtlas(FontHandle font, int pageSize): m_font(std::move(font)), m_pageSize(pageSize)
+{
+}
+
+void GlyphAtlas::checkFont()
+{
+    // not the TTF_Font address: a reloaded font may well be opened at the one just freed
+    if ( m_font->generation() == m_rasterizedWith )
+        return;
+    m_glyphs.clear();
+    m_kerning.clear();
+    m_pages.clear();
+    m_rasterizedWith = m_font->generation();
+}
+
+GlyphAtlas::Glyph& GlyphAtlas::glyph(char32_t codepoint)
+{
+    auto it = m_glyphs.find(codepoint);
+    if ( it != m_glyphs.end() )
+        return it->second;
+
+    Glyph g;
+    int minx = 0, maxx = 0, miny = 0, maxy = 0;
+    if ( 0 == TTF_GlyphMetrics32( m_font->get(), codepoint, &minx, &maxx, &miny, &maxy, &g.advance ) )
+        g.offsetX = std::min(0, minx);
+    return m_glyphs.emplace(codepoint, g).first->second;
+}
+
+int GlyphAtlas::kerning(char32_t previous, char32_t codepoint)
+{
+    const std::uint64_t pair = static_cast<std::uint64_t>(previous) << 32 | codepoint;
+    auto it = m_kerning.find(pair);
+    if ( it == m_kerning.end() )
+        it = m_kerning.emplace(pair, TTF_GetFontKerningSizeGlyphs32( m_font->get(), previous, codepoint )).first;
+    return it->second;
+}
+
+bool GlyphAtlas::rasterize(Context& ctx, char32_t codepoint, Glyph& glyph)
+{
+    glyph.rasterized = true;
+
+    // white, so that the vertex color tints it
+    std::unique_ptr<SDL_Surface> surface(TTF_RenderGlyph32_Blended( m_font->get(), codepoint, SDL_Color{0xFF, 0xFF, 0xFF, 0xFF} ));
+    if ( !surface || 0 == surface->w || 0 == surface->h )
+        return true;  // blanks only advance the pen
+
+    auto pixels = convertToArgb8888(surface.get());
+    if ( !pixels )
+        return false;
+
+    // one pixel of padding keeps linear filtering from bleeding neighbours in
+    std::optional<SDL_Rect> rect;
+    std::uint32_t page = 0;
+    for(; page < m_pages.size() && !rect; page++)
+        rect = m_pages[page].packer.insert(pixels->w + 1, pixels->h + 1);
+    if ( rect )
+        page--;
+    else
+    {
+        SDL_Texture* texture = SDL_CreateTexture( ctx.renderer(), SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STATIC,
+            m_pageSize, m_pageSize );
+        if ( NULL == texture )
+        {
+            std::cerr << "Unable to create glyph page! SDL_error: " << SDL_GetError() << std::endl;
+            return false;
+        }
+        SDL_SetTextureBlendMode( texture, SDL_BLENDMODE_BLEND );
+
+        // fresh textures are undefined, the padding has to be transparent
+        std::vector<std::uint32_t> clear(static_cast<std::size_t>(m_pageSize) * m_pageSize, 0);
+        SDL_UpdateTexture( texture, NULL, clear.data(), m_pageSize * 4 );
+
+        m_pages.push_back(Page{std::unique_ptr<SDL_Texture>(texture), SkylinePacker(m_pageSize, m_pageSize), {}});
+        rect = m_pages.back().packer.insert(pixels->w + 1, pixels->h + 1);
+        if ( !rect )
+        {
+            std::cerr << "Glyph of " << pixels->w << "x" << pixels->h << " doesn't fit a " << m_pageSize << " glyph page" << std::endl;
+            return false;
+        }
+    }
+
+    glyph.page = page;
+    glyph.rect = SDL_Rect{rect->x, rect->y, pixels->w, pixels->h};
+    SDL_UpdateTexture( m_pages[page].texture.get(), &glyph.rect, pixels->pixels, pixels->pitch );
+    m_uploads++;
+    return true;
+}
+
+template<typename F>
+SDL_Point GlyphAtlas::layout(std::string_view text, F&& f)
+{
+    checkFont();
+    const int lineSkip = TTF_FontLineSkip( m_font->get() );
+    const int height = TTF_FontHeight( m_font->get() );
+
+    int penX = 0;
+    int penY = 0;
+    int width = 0;
+    char32_t previous = 0;
+    for(std::size_t i = 0; i < text.size(); )
+    {
+        const char32_t codepoint = nextCodepoint(text, i);
+        if ( '\n' == codepoint )
+        {
+            penX = 0;
+            penY += lineSkip;
+            previous = 0;
+            continue;
+        }
+
+        if ( previous )
+            penX += kerning(previous, codepoint);
+        Glyph& g = glyph(codepoint);
+        f(codepoint, g, penX + g.offsetX, penY);
+        penX += g.advance;
+        width = std::max(width, penX);
+        previous = codepoint;
+    }
+    return SDL_Point{width, text.empty() ? 0 : penY + height};
+}
+
+void GlyphAtlas::preload(Context& ctx, std::string_view text)
+{
+    layout(text, [&](char32_t codepoint, Glyph& g, int, int) {
+        if ( !g.rasterized )
+            rasterize(ctx, codepoint, g);
+    });
+}
+
+SDL_Point GlyphAtlas::measure(std::string_view text)
+{
+    return layout(text, [](char32_t, Glyph&, int, int) {});
+}
+
+SDL_Point GlyphAtlas::render(Context& ctx, std::string_view text, float x, float y, SDL_Color color)
+{
+    for(Page& page : m_pages)
+        page.vertices.clear();
+
+    const SDL_Point size = layout(text, [&](char32_t codepoint, Glyph& g, int gx, int gy) {
+        if ( !g.rasterized && !rasterize(ctx, codepoint, g) )
+            return;
+        if ( 0 == g.rect.w )
+            return;
+
+        const float inv = 1.0f / m_pageSize;
+        const float u0 = g.rect.x * inv;
+        const float v0 = g.rect.y * inv;
+        const float u1 = (g.rect.x + g.rect.w) * inv;
+        const float v1 = (g.rect.y + g.rect.h) * inv;
+        const float left = x + gx;
+        const float top = y + gy;
+        const float right = left + g.rect.w;
+        const float bottom = top + g.rect.h;
+
+        auto& vertices = m_pages[g.page].vertices;
+        vertices.push_back({{left, top}, color, {u0, v0}});
+        vertices.push_back({{right, top}, color, {u1, v0}});
+        vertices.push_back({{right, bottom}, color, {u1, v1}});
+        vertices.push_back({{left, bottom}, color, {u0, v1}});
+    });
+
+    m_drawCalls = 0;
+    for(const Page& page : m_pages)
+    {
+        const std::size_t quads = page.vertices.size() / 4;
+        if ( 0 == quads )
+            continue;
+
+        for(auto q = static_cast<int>(m_indices.size() / 6); q < static_cast<int>(quads); q++)
+        {
+            const int v = q * 4;
+            m_indices.insert(m_indices.end(), {v, v + 1, v + 2, v, v + 2, v + 3});
+        }
+
+        SDL_RenderGeometry( ctx.renderer(), page.texture.get(), page.vertices.data(), static_cast<int>(page.vertices.size()),
+            m_indices.data(), static_cast<int>(quads * 6) );
+        m_drawCalls++;
+    }
+    return size;
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include <SDL.h>
+#include <SDL_ttf.h>
+
+#include "assets.hpp"
+#include "atlas.hpp"
+#include "context.hpp"
+#include "texture.hpp"
+
+// Text drawn from glyphs rasterized once per font into atlas pages.
+// A glyph is rendered and uploaded the first time it is drawn; after that text costs one batch of quads per page,
+// with no surfaces, textures or uploads, however often it changes. Text is UTF-8; glyphs are rasterized white
+// and tinted per draw. If the font behind the handle is reloaded the glyphs are rasterized again.
+class GlyphAtlas
+{
+public:
+    explicit GlyphAtlas(FontHandle font, int pageSize = 512);
+
+    GlyphAtlas(GlyphAtlas&&) = default;
+    GlyphAtlas& operator=(GlyphAtlas&&) = default;
+
+    // Rasterizes the glyphs of text ahead of time, e.g. the digits of a counter
+    void preload(Context& ctx, std::string_view text);
+
+    // x, y is the top left of the first line; lines are split at '\n'. Returns the size of the text.
+    SDL_Point render(Context& ctx, std::string_view text, float x, float y, SDL_Color color = {0, 0, 0, 0xFF});
+    SDL_Point measure(std::string_view text);
+
+    int lineHeight() const {return TTF_FontLineSkip( m_font->get() );}
+
+    std::size_t glyphCount() const noexcept {return m_glyphs.size();}
+    std::size_t pageCount() const noexcept {return m_pages.size();}
+    // Glyph uploads so far; stays put once the text only uses glyphs seen before
+    std::size_t uploads() const noexcept {return m_uploads;}
+    // Number of SDL draw submissions made by the last render()
+    std::size_t drawCalls() const noexcept {return m_drawCalls;}
+
+private:
+    struct Glyph
+    {
+        SDL_Rect rect{0, 0, 0, 0};  // in its page, empty for blanks
+        std::uint32_t page{0};
+        int offsetX{0};  // from the pen position to the left of the rasterized cell
+        int advance{0};
+        bool rasterized{false};
+    };
+
+    struct Page
+    {
+        std::unique_ptr<SDL_Texture> texture;
+        SkylinePacker packer;
+        std::vector<SDL_Vertex> vertices;
+    };
+
+    // Drops every glyph if the font was reloaded since they were made
+    void checkFont();
+    Glyph& glyph(char32_t codepoint);
+    int kerning(char32_t previous, char32_t codepoint);
+    bool rasterize(Context& ctx, char32_t codepoint, Glyph& glyph);
+
+    // Runs f(codepoint, glyph, x, y) for every glyph of text, returns the size
+    template<typename F>
+    SDL_Point layout(std::string_view text, F&& f);
+
+    FontHandle m_font;
+    std::uint64_t m_rasterizedWith{0};  // font generation
+    int m_pageSize;
+    std::unordered_map<char32_t, Glyph> m_glyphs;
+    std::unordered_map<std::uint64_t, int> m_kerning;
+    std::vector<Page> m_pages;
+    std::vector<int> m_indices;  // two triangles per quad, shared by all pages
+    std::size_t m_uploads{0};
+    std::size_t m_drawCalls{0};
+};
@@ -0,0 +1,158 @@
+#include <iostream>
+#include <algorithm>
+
+#include "hot_reload.hpp"
+
+HotReloader::HotReloader(AssetCache& assets, JobSystem& jobs): m_assets(assets), m_jobs(jobs)
+{
+    watchCached();
+}
+
+HotReloader::~HotReloader()
+{
+    m_jobs.wait(m_counter);
+}
+
+void HotReloader::onImageReload(const std::filesystem::path& path, ImageListener listener)
+{
+    m_imageListeners.emplace(path.lexically_normal(), std::move(listener));
+    m_watcher.watch(path);
+}
+
+void HotReloader::watchCached()
+{
+    // the size can't tell, a purge followed by as many new loads keeps it the same
+    if ( m_assets.insertions() == m_watchedInsertions )
+        return;
+    m_watchedInsertions = m_assets.insertions();
+
+    for(const auto& key : m_assets.keys())
+        if ( AssetCache::Kind::Music != key.kind )
+            m_watcher.watch(key.path);
+}
+
+void HotReloader::poll(Context& ctx)
+{
+    watchCached();
+
+    for(const auto& path : m_watcher.changes())
+        changed(path);
+
+    for(std::size_t i = 0; i < m_inFlight.size(); )
+    {
+        if ( !m_inFlight[i]->done.load(std::memory_order_acquire) )
+        {
+            i++;
+            continue;
+        }
+
+        auto reload = std::move(m_inFlight[i]);
+        m_inFlight.erase(m_inFlight.begin() + i);
+        apply(ctx, *reload);
+
+        if ( m_dirty.erase(reload->key) )
+            start(reload->key);
+    }
+}
+
+void HotReloader::changed(const std::filesystem::path& path)
+{
+    const std::string name = path.generic_string();
+    std::vector<AssetCache::Key> keys;
+    for(const auto& key : m_assets.keys())
+        if ( key.path == name && AssetCache::Kind::Music != key.kind )
+            keys.push_back(key);
+
+    const AssetCache::Key image{AssetCache::Kind::Image, name, 0};
+    const bool imageCached = std::any_of(keys.begin(), keys.end(), [](const auto& k) { return AssetCache::Kind::Image == k.kind; });
+    if ( !imageCached && m_imageListeners.count(path) )
+        keys.push_back(image);
+
+    for(const auto& key : keys)
+    {
+        const bool busy = std::any_of(m_inFlight.begin(), m_inFlight.end(),
+            [&](const auto& r) { return !(r->key < key) && !(key < r->key); });
+        if ( busy )
+            m_dirty.insert(key);
+        else
+            start(key);
+    }
+}
+
+void HotReloader::start(const AssetCache::Key& key)
+{
+    auto reload = std::make_shared<Reload>();
+    reload->key = key;
+    m_inFlight.push_back(reload);
+
+    m_jobs.submit([reload]() {
+        const std::filesystem::path path = reload->key.path;
+        switch (reload->key.kind)
+        {
+            case AssetCache::Kind::Texture:
+            case AssetCache::Kind::Image:
+                reload->surface = loadImage(path);
+                break;
+            case AssetCache::Kind::Font:
+                reload->font = loadFont(path, reload->key.param);
+                break;
+            case AssetCache::Kind::Chunk:
+                reload->chunk = loadChunk(path);
+                break;
+            case AssetCache::Kind::Music:
+                break;
+        }
+        reload->done.store(true, std::memory_order_release);
+    }, &m_counter);
+}
+
+void HotReloader::apply(Context& ctx, Reload& reload)
+{
+    const std::filesystem::path path = reload.key.path;
+    bool reloaded = false;
+    switch (reload.key.kind)
+    {
+        case AssetCache::Kind::Texture:
+        {
+            if ( !reload.surface )
+                break;
+            SDL_Texture* texture = SDL_CreateTextureFromSurface( ctx.renderer(), reload.surface.get() );
+            if ( NULL == texture )
+            {
+                std::cerr << "Unable to create texture from " << path << "! SDL_error: " << SDL_GetError() << std::endl;
+                break;
+            }
+            reloaded = m_assets.reload(path, Texture(texture, reload.surface->w, reload.surface->h));
+            break;
+        }
+        case AssetCache::Kind::Image:
+        {
+            if ( !reload.surface )
+                break;
+            ImageHandle image(std::move(reload.surface));
+            reloaded = m_assets.reload(path, image);
+            auto [begin, end] = m_imageListeners.equal_range(path);
+            for(auto it = begin; it != end; ++it)
+            {
+                it->second(*image);
+                reloaded = true;
+            }
+            break;
+        }
+        case AssetCache::Kind::Font:
+            reloaded = m_assets.reload(path, reload.key.param, std::move(reload.font));
+            break;
+        case AssetCache::Kind::Chunk:
+            reloaded = m_assets.reload(path, std::move(reload.chunk));
+            break;
+        case AssetCache::Kind::Music:
+            break;
+    }
+
+    // a failed decode (e.g. a half written file) keeps the old asset, the next write triggers another try
+    if ( reloaded )
+    {
+        m_reloads++;
+        std::cout << "Reloaded " << path.string() << std::endl;
+    }
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <memory>
+#include <set>
+#include <vector>
+
+#include <SDL.h>
+
+#include "assets.hpp"
+#include "context.hpp"
+#include "file_watcher.hpp"
+#include "job_system.hpp"
+
+// Reloads cached assets whose files change.
+// Textures, fonts and chunks are swapped behind the handles already given out, see AssetCache::reload.
+// Music is streamed from its file and is left alone.
+class HotReloader
+{
+public:
+    using ImageListener = std::function<void(SDL_Surface&)>;
+
+    HotReloader(AssetCache& assets, JobSystem& jobs);
+    // Waits for decoding still in flight, its results are dropped
+    ~HotReloader();
+
+    HotReloader(const HotReloader&) = delete;
+    HotReloader& operator=(const HotReloader&) = delete;
+
+    // Images are copied into other things (e.g. an atlas), whoever did that has to copy the new pixels too.
+    // The path is watched even when the image is no longer cached.
+    void onImageReload(const std::filesystem::path& path, ImageListener listener);
+
+    // Once per frame on the thread owning the renderer: starts decoding changed files on the job system
+    // and swaps in what has finished decoding. Never waits for a decode.
+    void poll(Context& ctx);
+
+    std::size_t reloadCount() const noexcept {return m_reloads;}
+
+private:
+    struct Reload
+    {
+        AssetCache::Key key;
+        std::unique_ptr<SDL_Surface> surface;
+        Font font;
+        MixChunk chunk;
+        std::atomic<bool> done{false};
+    };
+
+    void watchCached();
+    void changed(const std::filesystem::path& path);
+    void start(const AssetCache::Key& key);
+    void apply(Context& ctx, Reload& reload);
+
+    AssetCache& m_assets;
+    JobSystem& m_jobs;
+    JobSystem::Counter m_counter;
+    FileWatcher m_watcher;
+    std::size_t m_watchedInsertions{0};
+
+    std::vector<std::shared_ptr<Reload>> m_inFlight;
+    // changed again while decoding, decoded once more after the current one is swapped in
+    std::set<AssetCache::Key> m_dirty;
+    std::multimap<std::filesystem::path, ImageListener> m_imageListeners;
+    std::size_t m_reloads{0};
+};
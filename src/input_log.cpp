@@ -0,0 +1,213 @@
+#include <iostream>
+#include <cstring>
+
+#include "input_log.hpp"
+
+namespace
+{
+
+// version 2 added the world size and mouse wheel events
+const char logMagic[8] = {'S', 'D', 'L', 'P', 'R', 'E', 'C', '2'};
+const char logMagicV1[8] = {'S', 'D', 'L', 'P', 'R', 'E', 'C', '1'};
+const float v1WorldWidth = 1280;
+const float v1WorldHeight = 960;
+
+template<typename T>
+void put(std::ostream& os, const T& value)
+{
+    os.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+template<typename T>
+bool get(std::istream& is, T& value)
+{
+    return static_cast<bool>(is.read(reinterpret_cast<char*>(&value), sizeof(value)));
+}
+
+bool isRecorded(const SDL_Event& e)
+{
+    switch (e.type) {
+        case SDL_QUIT:
+        case SDL_KEYDOWN:
+        case SDL_KEYUP:
+        case SDL_MOUSEMOTION:
+        case SDL_MOUSEBUTTONDOWN:
+        case SDL_MOUSEBUTTONUP:
+        case SDL_MOUSEWHEEL:
+            return true;
+    }
+    return false;
+}
+
+void putEvent(std::ostream& os, const SDL_Event& e)
+{
+    put<std::uint32_t>(os, e.type);
+    switch (e.type) {
+        case SDL_QUIT:
+            put<std::uint32_t>(os, e.quit.timestamp);
+            break;
+        case SDL_KEYDOWN:
+        case SDL_KEYUP:
+            put<std::uint32_t>(os, e.key.timestamp);
+            put<std::int32_t>(os, e.key.keysym.sym);
+            put<std::int32_t>(os, e.key.keysym.scancode);
+            put<std::uint16_t>(os, e.key.keysym.mod);
+            put<std::uint8_t>(os, e.key.repeat);
+            break;
+        case SDL_MOUSEMOTION:
+            put<std::uint32_t>(os, e.motion.timestamp);
+            put<std::int32_t>(os, e.motion.x);
+            put<std::int32_t>(os, e.motion.y);
+            break;
+        case SDL_MOUSEBUTTONDOWN:
+        case SDL_MOUSEBUTTONUP:
+            put<std::uint32_t>(os, e.button.timestamp);
+            put<std::int32_t>(os, e.button.x);
+            put<std::int32_t>(os, e.button.y);
+            put<std::uint8_t>(os, e.button.button);
+            break;
+        case SDL_MOUSEWHEEL:
+            put<std::uint32_t>(os, e.wheel.timestamp);
+            put<std::int32_t>(os, e.wheel.x);
+            put<std::int32_t>(os, e.wheel.y);
+            put<std::uint32_t>(os, e.wheel.direction);
+            break;
+    }
+}
+
+bool getEvent(std::istream& is, SDL_Event& e)
+{
+    std::memset(&e, 0, sizeof(e));
+
+    std::uint32_t type = 0;
+    if ( !get(is, type) )
+        return false;
+    e.type = type;
+
+    std::int32_t sym = 0, scancode = 0;
+    std::uint16_t mod = 0;
+    std::uint8_t repeat = 0;
+    switch (e.type) {
+        case SDL_QUIT:
+            return get(is, e.quit.timestamp);
+        case SDL_KEYDOWN:
+        case SDL_KEYUP:
+            if ( !get(is, e.key.timestamp) || !get(is, sym) || !get(is, scancode) || !get(is, mod) || !get(is, repeat) )
+                return false;
+            e.key.keysym.sym = static_cast<SDL_Keycode>(sym);
+            e.key.keysym.scancode = static_cast<SDL_Scancode>(scancode);
+            e.key.keysym.mod = mod;
+            e.key.repeat = repeat;
+            e.key.state = SDL_KEYDOWN == e.type ? SDL_PRESSED : SDL_RELEASED;
+            return true;
+        case SDL_MOUSEMOTION:
+            return get(is, e.motion.timestamp) && get(is, e.motion.x) && get(is, e.motion.y);
+        case SDL_MOUSEBUTTONDOWN:
+        case SDL_MOUSEBUTTONUP:
+            e.button.state = SDL_MOUSEBUTTONDOWN == e.type ? SDL_PRESSED : SDL_RELEASED;
+            return get(is, e.button.timestamp) && get(is, e.button.x) && get(is, e.button.y) && get(is, e.button.button);
+        case SDL_MOUSEWHEEL:
+            return get(is, e.wheel.timestamp) && get(is, e.wheel.x) && get(is, e.wheel.y) && get(is, e.wheel.direction);
+    }
+
+    std::cerr << "Unknown event type " << type << " in input log" << std::endl;
+    return false;
+}
+
+}
+
+void InputRecorder::write(const FrameInput& frame)
+{
+    std::uint16_t count = 0;
+    for(const SDL_Event& e : frame.events)
+        if ( isRecorded(e) && count < UINT16_MAX )
+            count++;
+
+    put<std::uint16_t>(m_out, static_cast<std::uint16_t>(frame.ticks));
+    put<std::uint8_t>(m_out, frame.arrows);
+    put<std::uint16_t>(m_out, count);
+    for(const SDL_Event& e : frame.events)
+    {
+        if ( 0 == count )
+            break;
+        if ( isRecorded(e) )
+        {
+            putEvent(m_out, e);
+            count--;
+        }
+    }
+}
+
+bool InputReplayer::read(FrameInput& frame)
+{
+    std::uint16_t ticks = 0;
+    std::uint16_t count = 0;
+    if ( !get(m_in, ticks) || !get(m_in, frame.arrows) || !get(m_in, count) )
+        return false;
+
+    frame.ticks = ticks;
+    frame.events.resize(count);
+    for(SDL_Event& e : frame.events)
+        if ( !getEvent(m_in, e) )
+            return false;
+
+    return true;
+}
+
+std::optional<InputRecorder> createInputRecorder(const std::filesystem::path& path, const InputLogHeader& header)
+{
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if ( !out )
+    {
+        std::cerr << "Unable to create input log " << path << std::endl;
+        return std::nullopt;
+    }
+
+    out.write(logMagic, sizeof(logMagic));
+    put(out, header.seed);
+    put(out, header.ballCount);
+    put(out, header.tickRate);
+    put(out, header.worldWidth);
+    put(out, header.worldHeight);
+
+    return InputRecorder(std::move(out));
+}
+
+std::optional<InputReplayer> openInputReplay(const std::filesystem::path& path)
+{
+    std::ifstream in(path, std::ios::binary);
+    if ( !in )
+    {
+        std::cerr << "Unable to open input log " << path << std::endl;
+        return std::nullopt;
+    }
+
+    char magic[sizeof(logMagic)];
+    InputLogHeader header;
+    if ( !in.read(magic, sizeof(magic)) )
+    {
+        std::cerr << "Bad input log header in " << path << std::endl;
+        return std::nullopt;
+    }
+
+    const bool v1 = 0 == std::memcmp(magic, logMagicV1, sizeof(magic));
+    if ( (!v1 && 0 != std::memcmp(magic, logMagic, sizeof(magic)))
+        || !get(in, header.seed) || !get(in, header.ballCount) || !get(in, header.tickRate) )
+    {
+        std::cerr << "Bad input log header in " << path << std::endl;
+        return std::nullopt;
+    }
+
+    if ( v1 )
+    {
+        header.worldWidth = v1WorldWidth;
+        header.worldHeight = v1WorldHeight;
+    }
+    else if ( !get(in, header.worldWidth) || !get(in, header.worldHeight) )
+    {
+        std::cerr << "Bad input log header in " << path << std::endl;
+        return std::nullopt;
+    }
+
+    return InputReplayer(std::move(in), header);
+}
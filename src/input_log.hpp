@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <vector>
+
+#include <SDL.h>
+
+// Everything start() consumes from the outside world during one frame
+struct FrameInput
+{
+    enum Arrow : std::uint8_t { Up = 1, Down = 2, Left = 4, Right = 8 };
+
+    int ticks{0};               // fixed simulation steps run in this frame
+    std::uint8_t arrows{0};     // arrow keys held, as Arrow bits
+    std::vector<SDL_Event> events;
+};
+
+// What is needed to rebuild the same Scene before the first frame
+struct InputLogHeader
+{
+    std::uint32_t seed{0};
+    std::uint64_t ballCount{0};
+    double tickRate{0};
+    float worldWidth{0};
+    float worldHeight{0};
+};
+
+// Binary log: header, then one record per frame holding the tick count, the
+// arrow mask and the events we react to (quit, keys, mouse buttons, motion and wheel) in a compact form.
+// Values are written in host byte order; logs are meant to be replayed on the same kind of box.
+class InputRecorder
+{
+public:
+    explicit InputRecorder(std::ofstream&& out): m_out(std::move(out)) {}
+
+    void write(const FrameInput& frame);
+
+private:
+    std::ofstream m_out;
+};
+
+class InputReplayer
+{
+public:
+    InputReplayer(std::ifstream&& in, const InputLogHeader& header): m_in(std::move(in)), m_header(header) {}
+
+    const InputLogHeader& header() const noexcept {return m_header;}
+
+    // false at the end of the log
+    bool read(FrameInput& frame);
+
+private:
+    std::ifstream m_in;
+    InputLogHeader m_header;
+};
+
+std::optional<InputRecorder> createInputRecorder(const std::filesystem::path& path, const InputLogHeader& header);
+std::optional<InputReplayer> openInputReplay(const std::filesystem::path& path);
@@ -0,0 +1,128 @@
+#include "job_system.hpp"
+#include "profiler.hpp"
+
+namespace
+{
+    // Which pool the current thread works for and which deque is its own
+    thread_local const JobSystem* t_owner = nullptr;
+    thread_local std::size_t t_queue = 0;
+}
+
+unsigned JobSystem::defaultWorkerCount()
+{
+    // the thread that waits on counters helps too, so leave a core for it
+    const unsigned cores = std::thread::hardware_concurrency();
+    return cores > 1 ? cores - 1 : 0;
+}
+
+JobSystem::JobSystem(unsigned workers)
+{
+    // last queue is shared by all threads that are not workers
+    for(unsigned i = 0; i < workers + 1; i++)
+        m_queues.push_back(std::make_unique<Queue>());
+
+    m_threads.reserve(workers);
+    for(unsigned i = 0; i < workers; i++)
+        m_threads.emplace_back([this, i]() { workerLoop(i); });
+}
+
+JobSystem::~JobSystem()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+        m_stop = true;
+    }
+    m_wakeUp.notify_all();
+
+    for(auto& thread : m_threads)
+        thread.join();
+}
+
+std::size_t JobSystem::currentQueue() const noexcept
+{
+    return this == t_owner ? t_queue : m_queues.size() - 1;
+}
+
+void JobSystem::submit(Job job, Counter* counter)
+{
+    if ( counter )
+        counter->m_pending.fetch_add(1, std::memory_order_relaxed);
+
+    Queue& queue = *m_queues[currentQueue()];
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.jobs.emplace_back(std::move(job), counter);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+        m_queued.fetch_add(1, std::memory_order_release);
+    }
+    m_wakeUp.notify_one();
+}
+
+bool JobSystem::runOne(std::size_t home)
+{
+    std::pair<Job, Counter*> item;
+    bool found = false;
+
+    {
+        Queue& own = *m_queues[home];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if ( !own.jobs.empty() )
+        {
+            item = std::move(own.jobs.back());
+            own.jobs.pop_back();
+            found = true;
+        }
+    }
+
+    for(std::size_t k = 1; !found && k < m_queues.size(); k++)
+    {
+        Queue& victim = *m_queues[(home + k) % m_queues.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if ( !victim.jobs.empty() )
+        {
+            item = std::move(victim.jobs.front());
+            victim.jobs.pop_front();
+            found = true;
+        }
+    }
+
+    if ( !found )
+        return false;
+
+    m_queued.fetch_sub(1, std::memory_order_relaxed);
+    item.first();
+    if ( item.second )
+        item.second->m_pending.fetch_sub(1, std::memory_order_release);
+    return true;
+}
+
+void JobSystem::workerLoop(std::size_t index)
+{
+    t_owner = this;
+    t_queue = index;
+    PROFILE_THREAD("worker");
+
+    while ( true )
+    {
+        if ( runOne(index) )
+            continue;
+
+        std::unique_lock<std::mutex> lock(m_sleepMutex);
+        m_wakeUp.wait(lock, [this]() { return m_stop || m_queued.load(std::memory_order_acquire) > 0; });
+        if ( m_stop )
+            return;
+    }
+}
+
+void JobSystem::wait(Counter& counter)
+{
+    const std::size_t home = currentQueue();
+    while ( !counter.done() )
+    {
+        if ( !runOne(home) )
+            std::this_thread::yield();
+    }
+}
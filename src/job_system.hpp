@@ -0,0 +1,95 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Small work-stealing thread pool.
+// Every worker owns a deque: it pushes and pops its own jobs at the back,
+// idle workers steal from the front of the others. Threads that are not
+// workers (the main thread) submit into a separate shared deque.
+class JobSystem
+{
+public:
+    using Job = std::function<void()>;
+
+    // Tracks how many jobs of a group are still pending
+    class Counter
+    {
+    public:
+        bool done() const noexcept { return 0 == m_pending.load(std::memory_order_acquire); }
+    private:
+        friend class JobSystem;
+        std::atomic<int> m_pending{0};
+    };
+
+    // workers == 0 means everything runs on the thread calling wait()
+    explicit JobSystem(unsigned workers = defaultWorkerCount());
+    ~JobSystem();
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    void submit(Job job, Counter* counter = nullptr);
+
+    // Blocks until counter is done, running queued jobs in the meantime
+    void wait(Counter& counter);
+
+    // Calls f(chunkBegin, chunkEnd) for consecutive chunks of at most grain elements and waits for all of them
+    template<typename F>
+    void parallelFor(std::size_t begin, std::size_t end, std::size_t grain, F&& f);
+
+    unsigned workerCount() const noexcept { return static_cast<unsigned>(m_threads.size()); }
+
+    static unsigned defaultWorkerCount();
+
+private:
+    struct Queue
+    {
+        std::mutex mutex;
+        std::deque<std::pair<Job, Counter*>> jobs;
+    };
+
+    void workerLoop(std::size_t index);
+    bool runOne(std::size_t home);
+    std::size_t currentQueue() const noexcept;
+
+    std::vector<std::unique_ptr<Queue>> m_queues;
+    std::vector<std::thread> m_threads;
+
+    std::atomic<int> m_queued{0};
+    std::atomic<bool> m_stop{false};
+    std::mutex m_sleepMutex;
+    std::condition_variable m_wakeUp;
+};
+
+template<typename F>
+void JobSystem::parallelFor(std::size_t begin, std::size_t end, std::size_t grain, F&& f)
+{
+    if ( begin >= end )
+        return;
+    if ( 0 == grain )
+        grain = 1;
+
+    if ( m_threads.empty() || end - begin <= grain )
+    {
+        for(std::size_t b = begin; b < end; b += grain)
+            f(b, std::min(b + grain, end));
+        return;
+    }
+
+    Counter counter;
+    for(std::size_t b = begin; b < end; b += grain)
+    {
+        const std::size_t e = std::min(b + grain, end);
+        submit([&f, b, e]() { f(b, e); }, &counter);
+    }
+    wait(counter);
+}
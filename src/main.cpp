@@ -5,6 +5,12 @@
 #include <optional>
 #include <cassert>
 #include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <string_view>
+#include <list>
+#include <map>
+#include <tuple>
 
 #include <SDL.h>
 #include <SDL_image.h>
@@ -13,43 +19,161 @@
 
 #include "context.hpp"
 #include "texture.hpp"
+#include "atlas.hpp"
+#include "glyph_atlas.hpp"
 #include "surface.hpp"
 #include "font.hpp"
 #include "music.hpp"
-#include "fps_counter.hpp"
+#include "assets.hpp"
+#include "asset_loader.hpp"
+#include "asset_pack.hpp"
+#include "sound_bank.hpp"
+#include "hot_reload.hpp"
+#include "mixer.hpp"
+#include "audio_backoff.hpp"
+#include "frame_timing.hpp"
+#include "profiler.hpp"
+#include "fixed_timestep.hpp"
+#include "job_system.hpp"
+#include "input_log.hpp"
+#include "snapshot.hpp"
 #include "ball.hpp"
 #include "scene.hpp"
+#include "camera.hpp"
 
+// Renders strings to textures and keeps the most recently used ones, up to a budget of texture bytes,
+// so labels and values that come back are drawn again without FreeType or a texture upload
 class TextMaker
 {
 public:
-  TextMaker(Font&& font): m_font(std::move(font)) { assert(m_font);}
+  explicit TextMaker(FontHandle font, std::size_t budgetBytes = 4 << 20):
+    m_font(std::move(font)), m_budget(budgetBytes) { assert(m_font && *m_font);}
+
+  // nullptr if the text can't be rendered
+  TextureHandle fromString(Context& ctx, std::string_view str, SDL_Color color = {0, 0, 0, 0xFF});
+
+  std::size_t size() const noexcept {return m_entries.size();}
+  std::size_t hits() const noexcept {return m_hits;}
+  std::size_t misses() const noexcept {return m_misses;}
+  double hitRatio() const noexcept {return m_hits + m_misses ? double(m_hits) / (m_hits + m_misses) : 1.0;}
+  std::size_t bytesCached() const noexcept {return m_bytes;}
 
-  std::optional<Texture> fromString(Context& ctx, const std::string& str)
-  {
-     return textureFromText(ctx, str.c_str(), m_font, m_textColor);
-  }
 private:
-  Font m_font;
-  SDL_Color m_textColor {0, 0, 0};
+  // keyed on the font generation, not its address, which a reloaded font may reuse
+  struct Key
+  {
+    std::string text;
+    std::uint64_t font;
+    Uint32 color;
+  };
+
+  struct KeyView
+  {
+    std::string_view text;
+    std::uint64_t font;
+    Uint32 color;
+  };
+
+  // transparent, so lookups don't copy the string
+  struct KeyLess
+  {
+    using is_transparent = void;
+    template<typename A, typename B>
+    bool operator()(const A& a, const B& b) const
+    {
+      return std::tie(a.font, a.color, a.text) < std::tie(b.font, b.color, b.text);
+    }
+  };
+
+  struct Entry;
+  using Entries = std::map<Key, Entry, KeyLess>;
+
+  // Forgets every entry rendered with an older generation of the font
+  void dropStale(std::uint64_t generation);
+
+  struct Entry
+  {
+    TextureHandle texture;
+    std::size_t bytes;
+    std::list<Entries::iterator>::iterator recent;
+  };
+
+  FontHandle m_font;
+  std::size_t m_budget;
+  Entries m_entries;
+  std::list<Entries::iterator> m_recent;  // most recently used first
+  std::size_t m_bytes{0};
+  std::size_t m_hits{0};
+  std::size_t m_misses{0};
 };
 
+TextureHandle TextMaker::fromString(Context& ctx, std::string_view str, SDL_Color color)
+{
+  const std::uint64_t generation = m_font->generation();
+  dropStale(generation);
+  const Uint32 packedColor = Uint32(color.r) << 24 | Uint32(color.g) << 16 | Uint32(color.b) << 8 | color.a;
+  auto it = m_entries.find(KeyView{str, generation, packedColor});
+  if ( it != m_entries.end() )
+  {
+    m_hits++;
+    m_recent.splice(m_recent.begin(), m_recent, it->second.recent);
+    return it->second.texture;
+  }
+
+  m_misses++;
+  auto texture = textureFromText(ctx, std::string(str), m_font->get(), color);
+  if ( !texture )
+    return nullptr;
+
+  Uint32 format = SDL_PIXELFORMAT_ARGB8888;
+  SDL_QueryTexture( texture->texture(), &format, NULL, NULL, NULL );
+  const std::size_t bytes = static_cast<std::size_t>(texture->width()) * texture->height() * SDL_BYTESPERPIXEL(format);
+
+  auto handle = std::make_shared<Texture>(std::move(texture).value());
+  it = m_entries.emplace(Key{std::string(str), generation, packedColor}, Entry{handle, bytes, {}}).first;
+  m_recent.push_front(it);
+  it->second.recent = m_recent.begin();
+  m_bytes += bytes;
+
+  // holders of an evicted texture keep it, the cache just forgets it
+  while ( m_bytes > m_budget && m_recent.size() > 1 )
+  {
+    m_bytes -= m_recent.back()->second.bytes;
+    m_entries.erase(m_recent.back());
+    m_recent.pop_back();
+  }
+  return handle;
+}
+
+void TextMaker::dropStale(std::uint64_t generation)
+{
+  // the map is ordered by generation first and there is only ever one font
+  while ( !m_entries.empty() && m_entries.begin()->first.font != generation )
+  {
+    auto stale = m_entries.begin();
+    m_bytes -= stale->second.bytes;
+    m_recent.erase(stale->second.recent);
+    m_entries.erase(stale);
+  }
+}
+
 class Media {
 public:
    Media() = delete;
-   explicit Media(Texture&&, Texture&&, Texture&&, Texture&&, Texture&& , Texture&&,
-                 MixMusic&&, MixChunk&&, MixChunk&&, MixChunk&&, MixChunk&&, Texture&&,
-                 TextMaker&&);
 
-   Texture m_mouseOutTexture;
-   Texture m_mouseMotionTexture;
-   Texture m_mouseButtonUpTexture;
-   Texture m_mouseButtonDownTexture;
+   // Decodes everything in parallel on the job system, then looks it up in the cache,
+   // so assets shared with other owners are loaded only once
+   static std::optional<Media> load(Context&, AssetCache&, JobSystem&);
+
+   // Rendered on first use, after that served from the text cache
+   TextureHandle label(Context& ctx, std::string_view text) {return m_textMaker.fromString(ctx, text);}
+   const TextMaker& textMaker() const noexcept {return m_textMaker;}
 
-   SDL_Texture* arrowTexture() noexcept {return m_arrowTexture.texture();}
-   SDL_Texture* defaultTexture() noexcept {return m_defaultTexture.texture();}
+   TextureRegion arrowImage() {return m_atlas.region(m_arrowImage);}
+   TextureRegion defaultImage() {return m_atlas.region(m_defaultImage);}
 
-   Texture& info() noexcept {return m_info;}
+   // Centered around x, drawn from the glyph atlas so changing it costs no texture uploads
+   void renderInfo(Context& ctx, int x, int y);
 
    Mix_Music* music() noexcept {return m_music.get();}
    Mix_Chunk* scratchChunk() noexcept {return m_scratchChunk.get();}
@@ -57,51 +181,127 @@ public:
    Mix_Chunk* mediumChunk() noexcept {return m_mediumChunk.get();}
    Mix_Chunk* highChunk() noexcept {return m_highChunk.get();}
 
-   void updateInfo(Context& ctx, const std::string& str);
+   void updateInfo(std::string_view str)
+   {
+       PROFILE_ZONE("Media::updateInfo");
+       m_info.assign(str);
+   }
+
+   // Keeps the atlas up to date when one of its image files changes
+   void watch(HotReloader& reloader);
 protected:
-    Texture m_arrowTexture;
-    Texture m_defaultTexture;
+    Media(TextMaker&&, TextureAtlas&&, GlyphAtlas&&);
+
+    // all images share one atlas page, so switching between them doesn't rebind textures
+    TextureAtlas m_atlas;
+    TextureAtlas::Handle m_arrowImage{0};
+    TextureAtlas::Handle m_defaultImage{0};
 
-    MixMusic m_music;
+    MusicHandle m_music;
 
-    MixChunk m_scratchChunk;
-    MixChunk m_lowChunk;
-    MixChunk m_mediumChunk;
-    MixChunk m_highChunk;
+    ChunkHandle m_scratchChunk;
+    ChunkHandle m_lowChunk;
+    ChunkHandle m_mediumChunk;
+    ChunkHandle m_highChunk;
 
-    Texture m_info;
+    GlyphAtlas m_text;
+    std::string m_info;
 
     TextMaker m_textMaker;
 };
-
-Media::Media(
-    Texture&& outTexture, Texture&& motionTexture, Texture&& upTexture, Texture&& downTexture,
-    Texture&& arrowTexture, Texture&& defaultTexture,
-    MixMusic&& music, MixChunk&& scratchChunk, MixChunk&& lowChunk,
-    MixChunk&& mediumChunk, MixChunk&& highChunk, Texture&& info,
-    TextMaker&& textMaker
-):
-  m_mouseOutTexture(std::move(outTexture)) ,
-  m_mouseMotionTexture(std::move(motionTexture)) ,
-  m_mouseButtonUpTexture(std::move(upTexture)) ,
-  m_mouseButtonDownTexture(std::move(downTexture)),
-  m_arrowTexture(std::move(arrowTexture)),
-  m_defaultTexture(std::move(defaultTexture)),
-  m_music(std::move(music)),
-  m_scratchChunk(std::move(scratchChunk)),
-  m_lowChunk(std::move(lowChunk)),
-  m_mediumChunk(std::move(mediumChunk)),
-  m_highChunk(std::move(highChunk)),
-  m_info(std::move(info)),
+Media::Media(TextMaker&& textMaker, TextureAtlas&& atlas, GlyphAtlas&& text):
+  m_atlas(std::move(atlas)),
+  m_text(std::move(text)),
   m_textMaker(std::move(textMaker))
 {
 }
 
-void Media::updateInfo(Context& ctx, const std::string& str)
+std::optional<Media> Media::load(Context& ctx, AssetCache& assets, JobSystem& jobs)
 {
-    auto infoOpt = m_textMaker.fromString(ctx, str);
-    if (infoOpt)
-        m_info = std::move(infoOpt).value();
+    const std::vector<std::filesystem::path> sounds{"media/scratch.wav", "media/high.wav", "media/medium.wav", "media/low.wav"};
+    // all sounds in the device format in one arena, read back in one go if `make bank` saved it
+    auto bank = std::filesystem::exists("media.bank") ? openSoundBank("media.bank") : nullptr;
+    if ( !bank )
+        bank = loadSoundBank(sounds, &jobs);
+    if ( bank )
+    {
+        assets.mount(bank);
+        std::cout << "Sound bank : " << bank->size() << " sounds, " << bank->bytesResident() / 1024 << " KB, loaded in "
+                  << bank->loadMs() << " ms" << std::endl;
+    }
+
+    AssetLoader loader(jobs, assets);
+    loader.font("media/lazy.ttf");
+    loader.image("media/up.png");
+    loader.image("media/default.png");
+    loader.music("media/beat.wav");
+    // served by the bank, unless it failed
+    for(const auto& sound : sounds)
+        loader.chunk(sound);
+    const bool loaded = loader.finish(ctx);
+    loader.report(std::cout);
+    if ( !loaded )
+        return std::nullopt;
+
+    auto font = assets.font("media/lazy.ttf");
+    if ( !font )
+        return std::nullopt;
+    TextMaker textMaker(std::move(font));
+
+    // the button labels are rendered once here and come from the text cache from then on
+    for(const char* label : {"Mouse Out", "Mouse Motion", "Mouse Up", "Mouse Down"})
+        if ( !textMaker.fromString(ctx, label) )
+            return std::nullopt;
+
+    auto arrowImage = assets.image("media/up.png");
+    auto defaultImage = assets.image("media/default.png");
+    if ( !arrowImage || !defaultImage )
+        return std::nullopt;
+
+    AtlasBuilder atlasBuilder;
+    const auto arrowHandle = atlasBuilder.add(arrowImage);
+    const auto defaultHandle = atlasBuilder.add(defaultImage);
+    auto atlas = atlasBuilder.build(ctx);
+    if ( !atlas )
+        return std::nullopt;
+
+    auto music = assets.music("media/beat.wav");
+    auto scratch = assets.chunk("media/scratch.wav");
+    auto high = assets.chunk("media/high.wav");
+    auto medium = assets.chunk("media/medium.wav");
+    auto low = assets.chunk("media/low.wav");
+    if ( !music || !scratch || !high || !medium || !low )
+        return std::nullopt;
+
+    GlyphAtlas text(assets.font("media/lazy.ttf"));
+    // everything the fps line can show, so updating it never rasterizes
+    text.preload(ctx, "fps : 0123456789., balls/draw calls abcdefghijklmnopqrstuvwxyz");
+
+    Media media(std::move(textMaker), std::move(atlas).value(), std::move(text));
+    media.m_arrowImage = arrowHandle;
+    media.m_defaultImage = defaultHandle;
+    media.m_music = std::move(music);
+    media.m_scratchChunk = std::move(scratch);
+    media.m_lowChunk = std::move(low);
+    media.m_mediumChunk = std::move(medium);
+    media.m_highChunk = std::move(high);
+
+    std::stringstream str;
+    str << "Milliseconds for initalizing and load media : " << SDL_GetTicks();
+    media.updateInfo(str.str());
+    return media;
+}
+
+void Media::watch(HotReloader& reloader)
+{
+    reloader.onImageReload("media/up.png", [this](SDL_Surface& image) { m_atlas.update(m_arrowImage, &image); });
+    reloader.onImageReload("media/default.png", [this](SDL_Surface& image) { m_atlas.update(m_defaultImage, &image); });
+}
+
+void Media::renderInfo(Context& ctx, int x, int y)
+{
+    const SDL_Point size = m_text.measure(m_info);
+    m_text.render(ctx, m_info, static_cast<float>(x - size.x / 2), static_cast<float>(y));
 }
 
 class Button {
@@ -124,8 +324,9 @@ void Button::handleEvent( const SDL_Event& e )
     if (SDL_MOUSEMOTION != e.type && SDL_MOUSEBUTTONDOWN != e.type && SDL_MOUSEBUTTONUP != e.type)
         return;
 
-    int x{0}, y{0};
-    SDL_GetMouseState(&x, &y);
+    // take the position from the event itself so recorded input replays the same way
+    const int x = SDL_MOUSEMOTION == e.type ? e.motion.x : e.button.x;
+    const int y = SDL_MOUSEMOTION == e.type ? e.motion.y : e.button.y;
 
     const bool isInside =
         x >= m_bounds.x &&
@@ -145,15 +346,16 @@ void Button::handleEvent( const SDL_Event& e )
 
 void Button::render(Context& ctx, Media& media)
 {
-    Texture* pointer { nullptr };
+    const char* label { nullptr };
 
     switch (m_eventType) {
-        case MouseEventType::Out: pointer = &media.m_mouseOutTexture; break;
-        case MouseEventType::Motion: pointer = &media.m_mouseMotionTexture; break;
-        case MouseEventType::Up: pointer = &media.m_mouseButtonUpTexture; break;
-        case MouseEventType::Down: pointer = &media.m_mouseButtonDownTexture; break;
+        case MouseEventType::Out: label = "Mouse Out"; break;
+        case MouseEventType::Motion: label = "Mouse Motion"; break;
+        case MouseEventType::Up: label = "Mouse Up"; break;
+        case MouseEventType::Down: label = "Mouse Down"; break;
     }
 
+    TextureHandle pointer = label ? media.label(ctx, label) : nullptr;
     if (nullptr == pointer)
     {
         std::cerr << "Can't choose texture in Button::render " << std::endl;
@@ -189,29 +391,188 @@ protected:
 
 void Arrow::render(Context& ctx, Media& media)
 {
-    SDL_Texture* arrowTexture = media.arrowTexture();
-    SDL_Texture* defaultTexture = media.defaultTexture();
+    TextureRegion arrowImage = media.arrowImage();
+    TextureRegion defaultImage = media.defaultImage();
 
     switch (m_arrowState) {
         case ArrowState::Left:
-            SDL_RenderCopyEx( ctx.renderer(), arrowTexture, NULL, &m_bounds, 270, NULL, SDL_FLIP_NONE );
+            arrowImage.render( ctx, &m_bounds, NULL, 270 );
             break;
         case ArrowState::Up:
-            SDL_RenderCopy( ctx.renderer(), arrowTexture, NULL, &m_bounds );
+            arrowImage.render( ctx, &m_bounds );
             break;
         case ArrowState::Right:
-            SDL_RenderCopyEx( ctx.renderer(), arrowTexture, NULL, &m_bounds, 90, NULL, SDL_FLIP_NONE );
+            arrowImage.render( ctx, &m_bounds, NULL, 90 );
             break;
         case ArrowState::Down:
-            SDL_RenderCopyEx( ctx.renderer(), arrowTexture, NULL, &m_bounds, 180, NULL, SDL_FLIP_NONE );
+            arrowImage.render( ctx, &m_bounds, NULL, 180 );
             break;
         case ArrowState::Default:
-            SDL_RenderCopy( ctx.renderer(), defaultTexture, NULL, &m_bounds);
+            defaultImage.render( ctx, &m_bounds );
             break;
     };
 }
 
-void start(Context& context, Media& media)
+// Picks a ball with the left mouse button and drags it around.
+// On release the ball keeps the velocity the mouse moved it with.
+class BallDragger {
+public:
+  void handleEvent(const SDL_Event&, Scene& scene, const Camera& camera, float stepSeconds);
+
+  // Keeps the dragged ball under the cursor after the scene has been stepped
+  void afterUpdate(Scene& scene, int ticks);
+
+protected:
+  void pin(Scene& scene);
+
+  std::optional<std::uint32_t> m_ball;
+  float m_x{0};
+  float m_y{0};
+  float m_vx{0};
+  float m_vy{0};
+  int m_ticksSinceMotion{0};
+  bool m_moved{false};
+  std::vector<std::uint32_t> m_hits;
+};
+
+void BallDragger::handleEvent(const SDL_Event& e, Scene& scene, const Camera& camera, float stepSeconds)
+{
+    if (SDL_MOUSEBUTTONDOWN == e.type && SDL_BUTTON_LEFT == e.button.button)
+    {
+        // a drag whose button-up was missed, e.g. released outside the window, ends here
+        m_ball.reset();
+        const float x = camera.toWorldX(e.button.x);
+        const float y = camera.toWorldY(e.button.y);
+        scene.ballsAt(x, y, m_hits);
+        if (m_hits.empty())
+            return;
+
+        // of all balls under the cursor take the one with the closest centre
+        float best = 0;
+        for (std::uint32_t id : m_hits)
+        {
+            const Ball b = scene.ball(id);
+            const float dx = b.p().x() - x;
+            const float dy = b.p().y() - y;
+            if (!m_ball || dx*dx + dy*dy < best)
+            {
+                m_ball = id;
+                best = dx*dx + dy*dy;
+            }
+        }
+
+        m_x = x;
+        m_y = y;
+        m_vx = m_vy = 0;
+        m_ticksSinceMotion = 0;
+        pin(scene);
+    }
+    else if (SDL_MOUSEMOTION == e.type && m_ball)
+    {
+        const float x = camera.toWorldX(e.motion.x);
+        const float y = camera.toWorldY(e.motion.y);
+        // time is measured in simulation ticks so a replayed drag throws the ball the same way
+        const float dt = std::max(m_ticksSinceMotion, 1) * stepSeconds;
+        m_vx = (x - m_x) / dt;
+        m_vy = (y - m_y) / dt;
+        m_x = x;
+        m_y = y;
+        m_ticksSinceMotion = 0;
+        m_moved = true;
+        pin(scene);
+    }
+    else if (SDL_MOUSEBUTTONUP == e.type && SDL_BUTTON_LEFT == e.button.button && m_ball)
+    {
+        pin(scene);
+        m_ball.reset();
+    }
+}
+
+// Right mouse button drags the view, the wheel zooms around the cursor
+class CameraController {
+public:
+  void handleEvent(const SDL_Event&, Camera& camera);
+
+protected:
+  bool m_panning{false};
+  int m_mouseX{0};
+  int m_mouseY{0};
+};
+
+void CameraController::handleEvent(const SDL_Event& e, Camera& camera)
+{
+    switch (e.type) {
+        case SDL_MOUSEBUTTONDOWN:
+            m_mouseX = e.button.x;
+            m_mouseY = e.button.y;
+            if (SDL_BUTTON_RIGHT == e.button.button)
+                m_panning = true;
+            break;
+        case SDL_MOUSEBUTTONUP:
+            if (SDL_BUTTON_RIGHT == e.button.button)
+                m_panning = false;
+            break;
+        case SDL_MOUSEMOTION:
+            if (m_panning)
+                camera.pan(m_mouseX - e.motion.x, m_mouseY - e.motion.y);
+            m_mouseX = e.motion.x;
+            m_mouseY = e.motion.y;
+            break;
+        case SDL_MOUSEWHEEL:
+        {
+            const int steps = SDL_MOUSEWHEEL_FLIPPED == e.wheel.direction ? -e.wheel.y : e.wheel.y;
+            camera.zoomAt(m_mouseX, m_mouseY, std::pow(1.25f, static_cast<float>(steps)));
+            break;
+        }
+    }
+}
+
+void BallDragger::afterUpdate(Scene& scene, int ticks)
+{
+    if (!m_ball)
+        return;
+
+    m_ticksSinceMotion += ticks;
+    if (!m_moved && ticks > 0)
+        m_vx = m_vy = 0;
+    m_moved = false;
+    pin(scene);
+}
+
+void BallDragger::pin(Scene& scene)
+{
+    const Ball b = scene.ball(*m_ball);
+    scene.setBall(*m_ball, Ball(vec2(m_x, m_y), b.r(), vec2(m_vx, m_vy)));
+}
+
+std::uint8_t arrowsFromKeyboard()
+{
+    const std::uint8_t* currentKeyStates = SDL_GetKeyboardState( NULL );
+    std::uint8_t arrows = 0;
+    if (currentKeyStates[ SDL_SCANCODE_UP ] )
+        arrows |= FrameInput::Up;
+    if (currentKeyStates[ SDL_SCANCODE_DOWN ] )
+        arrows |= FrameInput::Down;
+    if (currentKeyStates[ SDL_SCANCODE_LEFT ] )
+        arrows |= FrameInput::Left;
+    if (currentKeyStates[ SDL_SCANCODE_RIGHT ] )
+        arrows |= FrameInput::Right;
+    return arrows;
+}
+
+// Through our mixer when it is installed, on SDL_mixer's channels otherwise
+void playChunk(Mixer* mixer, Mix_Chunk* chunk)
+{
+    if ( mixer )
+        mixer->play(chunk);
+    else
+        Mix_PlayChannel(-1, chunk, 0);
+}
+
+// With a replayer the frames come from the log instead of SDL, with a recorder they are also saved
+void start(Context& context, Media& media, JobSystem& jobs, HotReloader& reloader, Mixer* mixer,
+    AudioBackoff* audioBackoff, Scene& scene, double tickRate, InputRecorder* recorder, InputReplayer* replayer,
+    bool timingTable)
 {
     const int w2 = context.width() / 2;
     const int h2 = context.height() / 2;
@@ -225,20 +586,69 @@ void start(Context& context, Media& media)
 
     Arrow arrow({.x = w2 - 100, .y = h2 - 100, .w = 200, .h = 200});
 
-    Scene scene;
+    BallDragger dragger;
+
+    // start with the whole world in view
+    Camera camera(context.width(), context.height());
+    camera.lookAt(scene.worldWidth() / 2, scene.worldHeight() / 2);
+    camera.setZoom(std::min(context.width() / scene.worldWidth(), context.height() / scene.worldHeight()));
+    CameraController cameraController;
 
-    SDL_Event e;
+    SDL_Event polled;
+    FrameInput frame;
     bool quit = false;
 
-    std::uint32_t lastFPS10 = 0;
-    FPSCounter fpsCounter;
+    FrameTiming timing;
 
+    // checkpoints are copied in memory and written out by the job system
+    JobSystem::Counter checkpoints;
+
+    FixedTimestep timestep(tickRate);
     std::chrono::steady_clock::time_point lastTime = std::chrono::steady_clock::now();
 
     while ( !quit )
     {
-        while ( SDL_PollEvent( &e ) )
-         {
+        PROFILE_ZONE("frame");
+        timing.beginFrame();
+
+        // changed media files are swapped in between frames
+        reloader.poll(context);
+        if ( audioBackoff )
+            audioBackoff->poll(media.music());
+        timing.lap(FrameTiming::Phase::Reload);
+
+        frame.events.clear();
+        while ( SDL_PollEvent( &polled ) )
+            frame.events.push_back(polled);
+        timing.lap(FrameTiming::Phase::Events);
+
+        const auto now = std::chrono::steady_clock::now();
+        const int ticks = timestep.advance(now - lastTime);
+        lastTime = now;
+
+        if ( replayer )
+        {
+            // only closing the window is taken from the live input during replay
+            for(const SDL_Event& live : frame.events)
+                if ( SDL_QUIT == live.type )
+                    quit = true;
+
+            if ( !replayer->read(frame) )
+                break;
+        }
+        else
+        {
+            frame.ticks = ticks;
+            frame.arrows = arrowsFromKeyboard();
+        }
+
+        timing.lap(FrameTiming::Phase::Keyboard);
+
+        if ( recorder )
+            recorder->write(frame);
+
+        for(const SDL_Event& e : frame.events)
+        {
               if (   SDL_QUIT == e.type
                   || (SDL_KEYDOWN == e.type &&  SDLK_q == e.key.keysym.sym)
                   )
@@ -251,16 +661,16 @@ void start(Context& context, Media& media)
                 switch (e.key.keysym.sym)
                 {
                     case SDLK_1:
-                        Mix_PlayChannel(-1, media.highChunk(), 0);
+                        playChunk(mixer, media.highChunk());
                         break;
                     case SDLK_2:
-                        Mix_PlayChannel(-1, media.mediumChunk(), 0);
+                        playChunk(mixer, media.mediumChunk());
                         break;
                     case SDLK_3:
-                        Mix_PlayChannel(-1, media.lowChunk(), 0);
+                        playChunk(mixer, media.lowChunk());
                         break;
                     case SDLK_4:
-                        Mix_PlayChannel(-1, media.scratchChunk(), 0);
+                        playChunk(mixer, media.scratchChunk());
                         break;
                     case SDLK_9:
                         if ( 0 == Mix_PlayingMusic() )
@@ -282,27 +692,39 @@ void start(Context& context, Media& media)
                     case SDLK_0:
                         Mix_HaltMusic();
                         break;
+                    case SDLK_t:
+                        timingTable = !timingTable;
+                        break;
+                    case SDLK_s:
+                        jobs.submit([balls = scene.balls(), seed = scene.seed(),
+                                     width = scene.worldWidth(), height = scene.worldHeight()]() {
+                            if (saveSnapshot("checkpoint.snap", balls, seed, width, height))
+                                std::cout << "Saved checkpoint.snap with " << balls.size() << " balls" << std::endl;
+                        }, &checkpoints);
+                        break;
                 };
             }
 
               for(auto& button : buttons)
                   button.handleEvent(e);
+
+              dragger.handleEvent(e, scene, camera, timestep.stepSeconds());
+              cameraController.handleEvent(e, camera);
         }
 
-       const std::uint8_t* currentKeyStates = SDL_GetKeyboardState( NULL );
-       if (currentKeyStates[ SDL_SCANCODE_UP ] )
+       if ( frame.arrows & FrameInput::Up )
        {
            arrow.setState( Arrow::ArrowState::Up );
        }
-       else if (currentKeyStates[ SDL_SCANCODE_DOWN ] )
+       else if ( frame.arrows & FrameInput::Down )
        {
            arrow.setState( Arrow::ArrowState::Down );
        }
-       else if (currentKeyStates[ SDL_SCANCODE_LEFT ] )
+       else if ( frame.arrows & FrameInput::Left )
        {
            arrow.setState( Arrow::ArrowState::Left );
        }
-       else if (currentKeyStates[ SDL_SCANCODE_RIGHT ] )
+       else if ( frame.arrows & FrameInput::Right )
        {
            arrow.setState( Arrow::ArrowState::Right );
        }
@@ -311,101 +733,219 @@ void start(Context& context, Media& media)
            arrow.setState( Arrow::ArrowState::Default );
        }
 
-       // Unpdate scene
-       const auto now = std::chrono::steady_clock::now();
-       scene.update(context, now - lastTime);
-       lastTime = now;
+       timing.lap(FrameTiming::Phase::Handling);
+
+       // Update scene in fixed steps, whatever the frame rate is
+       for(int i = 0; i < frame.ticks; i++)
+           scene.update(timestep.step());
+       dragger.afterUpdate(scene, frame.ticks);
+       timing.lap(FrameTiming::Phase::Update);
 
         // Let's Render
         SDL_RenderClear( context.renderer() );
+        timing.lap(FrameTiming::Phase::Clear);
         for(auto& button : buttons)
             button.render(context, media);
-        media.info().renderAt(context, w2 - media.info().width()/2, 50);
+        timing.lap(FrameTiming::Phase::Buttons);
+        media.renderInfo(context, w2, 50);
+        timing.lap(FrameTiming::Phase::Info);
         arrow.render(context, media);
-        scene.render(context);
-        SDL_RenderPresent( context.renderer() );
-
-       ++fpsCounter;
+        timing.lap(FrameTiming::Phase::Arrow);
+        scene.render(context, camera, replayer ? 1.0f : timestep.alpha());
+        timing.lap(FrameTiming::Phase::Scene);
+        {
+            PROFILE_ZONE("present");
+            SDL_RenderPresent( context.renderer() );
+        }
+        timing.lap(FrameTiming::Phase::Present);
 
-       const std::uint32_t fps10 = fpsCounter.fps10();
-       if (lastFPS10 != fps10)
+       if ( timing.endFrame() )
        {
-           std::stringstream str;
-           str << "fps : " << std::fixed << std::setprecision(1) << (fps10 / 10.0);
-           media.updateInfo(context, str.str());
-           lastFPS10 = fps10;
+           // formatted in place: the text changes every window and shouldn't allocate
+           char info[1024];
+           const int used = std::snprintf(info, sizeof(info), "fps : %.1f, balls : %zu/%zu, draw calls : %zu\n",
+               timing.fps(), scene.visibleCount(), scene.size(), scene.drawCalls());
+           if ( timingTable )
+               timing.formatTable(info + used, sizeof(info) - used, false);
+           else
+               timing.format(info + used, sizeof(info) - used, false);
+           media.updateInfo(info);
        }
     }
+
+    jobs.wait(checkpoints);
+    timing.dump(std::cout);
 }
 
-int main()
+// Writes the trace whichever way main() returns, a startup that failed is worth a look too. Declared before
+// the job system, so the workers are joined and idle by the time it runs.
+struct TraceWriter
+{
+    std::optional<std::filesystem::path> path;
+
+    ~TraceWriter()
+    {
+        if ( path && writeChromeTrace(*path) )
+            std::cout << "Trace : " << profiledZones() << " zones, " << droppedZones() << " overwritten, written to "
+                      << *path << std::endl;
+    }
+};
+
+int main(int argc, char* argv[])
 {
     //Screen dimension constants
     const int SCREEN_WIDTH = 1280;
     const int SCREEN_HEIGHT = 960;
 
-    auto contextOpt = createContext(SCREEN_WIDTH, SCREEN_HEIGHT);
-    if ( !contextOpt )
+    // The world is bigger than the window, the camera pans and zooms over it
+    float worldWidth = 2 * SCREEN_WIDTH;
+    float worldHeight = 2 * SCREEN_HEIGHT;
+
+    std::size_t ballCount = 10;
+    double tickRate = 120;
+    std::optional<std::filesystem::path> recordPath;
+    std::optional<std::filesystem::path> replayPath;
+    std::optional<std::filesystem::path> loadPath;
+    AudioProfile audioProfile = defaultAudioProfile;
+    std::optional<std::filesystem::path> tracePath;
+    // the overlay starts with every phase instead of the two-line summary, T switches between them
+    bool timingTable = false;
+    try
+    {
+        int position = 0;
+        for (int i = 1; i < argc; i++)
+        {
+            const std::string arg = argv[i];
+            if ("--record" == arg && i + 1 < argc)
+                recordPath = argv[++i];
+            else if ("--replay" == arg && i + 1 < argc)
+                replayPath = argv[++i];
+            else if ("--load" == arg && i + 1 < argc)
+                loadPath = argv[++i];
+            else if ("--audio" == arg && i + 1 < argc)
+                audioProfile = findAudioProfile(argv[++i]).value();
+            else if ("--trace" == arg && i + 1 < argc)
+                tracePath = argv[++i];
+            else if ("--timing" == arg)
+                timingTable = true;
+            else if (0 == position)
+            {
+                ballCount = std::stoul(arg);
+                position++;
+            }
+            else if (1 == position)
+            {
+                tickRate = std::stod(arg);
+                position++;
+            }
+            else
+                throw std::invalid_argument(arg);
+        }
+        if (tickRate <= 0)
+            throw std::invalid_argument("tick rate");
+        // logs only know how to rebuild a random scene from its seed
+        if (loadPath && (recordPath || replayPath))
+            throw std::invalid_argument("--load");
+    }
+    catch (const std::exception&)
+    {
+        std::cerr << "Usage: " << argv[0] << " [ball count] [ticks per second] [--record FILE | --replay FILE | --load SNAPSHOT]"
+                  << " [--audio safe|balanced|low|minimal] [--trace FILE] [--timing]" << std::endl;
         return -1;
-    auto context = std::move(contextOpt).value();
+    }
 
-    auto font = loadFont("media/lazy.ttf");
-    if ( !font )
-        return -1;
-    auto textMaker = TextMaker(std::move(font));
+    // from here on, so the trace shows where startup went too
+    if (tracePath)
+        startProfiling();
+    TraceWriter traceWriter{tracePath};
 
-    auto outTextureOpt = textMaker.fromString(context, "Mouse Out");
-    if ( !outTextureOpt )
-        return -1;
-    auto motionTextureOpt = textMaker.fromString(context, "Mouse Motion");
-    if ( !motionTextureOpt )
-        return -1;
-    auto upTextureOpt = textMaker.fromString(context, "Mouse Up");
-    if ( !upTextureOpt )
-        return -1;
+    std::optional<InputReplayer> replayer;
+    std::uint32_t seed = Scene::randomSeed();
+    if (replayPath)
+    {
+        replayer = openInputReplay(*replayPath);
+        if (! replayer)
+            return -1;
+        seed = replayer->header().seed;
+        ballCount = replayer->header().ballCount;
+        tickRate = replayer->header().tickRate;
+        worldWidth = replayer->header().worldWidth;
+        worldHeight = replayer->header().worldHeight;
+    }
 
-    auto downTextureOpt = textMaker.fromString(context, "Mouse Down");
-    if ( !downTextureOpt )
-        return -1;
+    std::optional<InputRecorder> recorder;
+    if (recordPath)
+    {
+        recorder = createInputRecorder(*recordPath, {.seed = seed, .ballCount = ballCount, .tickRate = tickRate,
+                                                    .worldWidth = worldWidth, .worldHeight = worldHeight});
+        if (! recorder)
+            return -1;
+    }
 
-    auto arrowImageOpt = loadTexture("media/up.png", context);
-    if ( !arrowImageOpt )
+    auto contextOpt = createContext(SCREEN_WIDTH, SCREEN_HEIGHT, audioProfile);
+    if ( !contextOpt )
         return -1;
+    auto context = std::move(contextOpt).value();
 
-    auto defaultImageOpt = loadTexture("media/default.png", context);
-    if ( !defaultImageOpt )
+    JobSystem jobs;
+    AssetCache assets;
+    // made by `make pack`, whatever it holds is used without decoding
+    if ( std::filesystem::exists("media.pack") )
+        assets.mount(openAssetPack("media.pack"));
+    auto media = Media::load(context, assets, jobs);
+    if ( !media )
         return -1;
 
-    auto music = loadMusic("media/beat.wav");
-    if (! music)
-        return -1;
-    auto scratch = loadChunk("media/scratch.wav");
-    if (! scratch)
-        return -1;
-    auto high = loadChunk("media/high.wav");
-    if (! high)
-        return -1;
-    auto medium = loadChunk("media/medium.wav");
-    if (! medium)
-        return -1;
-    auto low = loadChunk("media/low.wav");
-    if (! low)
+    // the decoded images were only needed to fill the atlas
+    assets.purgeUnused();
+    std::cout << "Assets : " << assets.size() << " resident, " << assets.bytesResident() / 1024 << " KB, "
+              << assets.hits() << " hits, " << assets.misses() << " misses" << std::endl;
+
+    Mixer mixer;
+    const bool mixing = mixer.install();
+    // chunks are reloaded in place, the voices still playing the old samples have to go first
+    assets.onChunkRelease([&mixer](Mix_Chunk& chunk) { mixer.release(chunk); });
+    // underruns are only counted by our mixer
+    std::optional<AudioBackoff> audioBackoff;
+    if ( mixing )
+        audioBackoff.emplace(context, mixer);
+
+    HotReloader reloader(assets, jobs);
+    media->watch(reloader);
+
+    std::optional<Scene> scene;
+    if (loadPath)
+        scene = loadSnapshot(*loadPath, &jobs);
+    else
+        scene.emplace(ballCount, &jobs, seed, worldWidth, worldHeight);
+    if (! scene)
         return -1;
 
-    std::stringstream str;
-    str << "Milliseconds for initalizing and load media : " << SDL_GetTicks();
-    auto infoOpt = textMaker.fromString(context,   str.str());
-    if (! infoOpt)
-        return -1;
+    start( context, *media, jobs, reloader, mixing ? &mixer : nullptr, audioBackoff ? &*audioBackoff : nullptr,
+        *scene, tickRate, recorder ? &*recorder : nullptr, replayer ? &*replayer : nullptr,
+        timingTable );
+    mixer.uninstall();
 
-    Media media(std::move(outTextureOpt).value(), std::move(motionTextureOpt).value(),
-        std::move(upTextureOpt).value(), std::move(downTextureOpt).value(),
-        std::move(arrowImageOpt).value(), std::move(defaultImageOpt).value(),
-        std::move(music), std::move(scratch), std::move(low),
-        std::move(medium), std::move(high), std::move(infoOpt).value(),
-        std::move(textMaker) );
+    const TextMaker& text = media->textMaker();
+    std::cout << "Text cache : " << text.size() << " textures, " << text.bytesCached() / 1024 << " KB, "
+              << text.hits() << " hits, " << text.misses() << " misses, hit ratio " << text.hitRatio() << std::endl;
 
-    start( context, media );
+    if ( mixing )
+    {
+        const Mixer::Stats audio = mixer.stats();
+        std::cout << "Mixer (" << mixer.kernels().name << ") : " << audio.callbacks << " callbacks, "
+                  << (audio.callbacks ? audio.mixMs / audio.callbacks : 0.0) << " ms average, " << audio.worstMixMs
+                  << " ms worst, " << audio.underruns << " underruns, " << audio.peakVoices << " peak voices, "
+                  << audio.steals << " steals, " << audio.drops << " drops, " << audio.overflows << " overflows"
+                  << std::endl;
+        std::cout << "Audio : " << audioProfile.name << " profile, " << audio.periodMs << " ms period, "
+                  << audio.jitterMs << " ms jitter, " << audio.worstIntervalMs << " ms worst interval, "
+                  << audioBackoff->backoffs() << " back-offs";
+        if ( context.audio() )
+            std::cout << ", ended at " << context.audio()->chunkSize << " samples at " << context.audio()->frequency
+                      << " Hz (" << context.audio()->latencyMs() << " ms)";
+        std::cout << std::endl;
+    }
 
     SDL_Quit();
 }
@@ -0,0 +1,62 @@
+#include <iostream>
+#include <cerrno>
+#include <cstring>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "mapped_file.hpp"
+
+MappedFile::~MappedFile()
+{
+    if ( m_data )
+        munmap( m_data, m_size );
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept:
+    m_data(std::exchange(other.m_data, nullptr)), m_size(std::exchange(other.m_size, 0))
+{
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+{
+    if ( this != &other )
+    {
+        if ( m_data )
+            munmap( m_data, m_size );
+        m_data = std::exchange(other.m_data, nullptr);
+        m_size = std::exchange(other.m_size, 0);
+    }
+    return *this;
+}
+
+std::optional<MappedFile> mapFile(const std::filesystem::path& path)
+{
+    const int fd = open( path.c_str(), O_RDONLY );
+    if ( -1 == fd )
+    {
+        std::cerr << "Unable to open " << path << ": " << std::strerror(errno) << std::endl;
+        return std::nullopt;
+    }
+
+    struct stat st;
+    if ( -1 == fstat( fd, &st ) || 0 == st.st_size )
+    {
+        std::cerr << "Unable to map empty or unreadable file " << path << std::endl;
+        close( fd );
+        return std::nullopt;
+    }
+
+    void* data = mmap( nullptr, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0 );
+    close( fd );
+    if ( MAP_FAILED == data )
+    {
+        std::cerr << "Unable to map " << path << ": " << std::strerror(errno) << std::endl;
+        return std::nullopt;
+    }
+
+    return MappedFile(data, st.st_size);
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+
+// Whole file mapped into memory, unmapped on destruction.
+// The mapping is private: pages can be written, but changes never reach the file.
+class MappedFile
+{
+public:
+    MappedFile(void* data, std::size_t size): m_data(static_cast<std::uint8_t*>(data)), m_size(size) {}
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    std::uint8_t* data() noexcept {return m_data;}
+    const std::uint8_t* data() const noexcept {return m_data;}
+    std::size_t size() const noexcept {return m_size;}
+
+private:
+    std::uint8_t* m_data{nullptr};
+    std::size_t m_size{0};
+};
+
+std::optional<MappedFile> mapFile(const std::filesystem::path& path);
@@ -0,0 +1,444 @@
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+#include <SDL.h>
+#include <SDL_mixer.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define MIXER_X86 1
+#endif
+
+#include "mixer.hpp"
+
+namespace
+{
+
+// the float sum is clamped before the conversion, so that it can't overflow int32 either
+constexpr float sampleMin = -32768.0f;
+constexpr float sampleMax = 32767.0f;
+
+void accumulateScalar(float* acc, const Sint16* src, std::size_t n, float gain)
+{
+    for(std::size_t i = 0; i < n; i++)
+        acc[i] += static_cast<float>(src[i]) * gain;
+}
+
+void resolveScalar(Sint16* out, const float* acc, std::size_t n)
+{
+    for(std::size_t i = 0; i < n; i++)
+    {
+        const float v = std::clamp(static_cast<float>(out[i]) + acc[i], sampleMin, sampleMax);
+        // nearest, ties to even, as cvtps2dq does
+        out[i] = static_cast<Sint16>(std::lrint(v));
+    }
+}
+
+#ifdef MIXER_X86
+
+// multiply and add stay separate (no FMA), so every variant gives the scalar result bit for bit
+
+__attribute__((target("sse4.1")))
+void accumulateSSE(float* acc, const Sint16* src, std::size_t n, float gain)
+{
+    const __m128 g = _mm_set1_ps(gain);
+    std::size_t i = 0;
+    for(; i + 8 <= n; i += 8)
+    {
+        const __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        const __m128 lo = _mm_cvtepi32_ps(_mm_cvtepi16_epi32(s));
+        const __m128 hi = _mm_cvtepi32_ps(_mm_cvtepi16_epi32(_mm_srli_si128(s, 8)));
+        _mm_storeu_ps(acc + i, _mm_add_ps(_mm_loadu_ps(acc + i), _mm_mul_ps(lo, g)));
+        _mm_storeu_ps(acc + i + 4, _mm_add_ps(_mm_loadu_ps(acc + i + 4), _mm_mul_ps(hi, g)));
+    }
+    accumulateScalar(acc + i, src + i, n - i, gain);
+}
+
+__attribute__((target("sse4.1")))
+void resolveSSE(Sint16* out, const float* acc, std::size_t n)
+{
+    const __m128 low = _mm_set1_ps(sampleMin);
+    const __m128 high = _mm_set1_ps(sampleMax);
+    std::size_t i = 0;
+    for(; i + 8 <= n; i += 8)
+    {
+        const __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(out + i));
+        __m128 lo = _mm_add_ps(_mm_cvtepi32_ps(_mm_cvtepi16_epi32(s)), _mm_loadu_ps(acc + i));
+        __m128 hi = _mm_add_ps(_mm_cvtepi32_ps(_mm_cvtepi16_epi32(_mm_srli_si128(s, 8))), _mm_loadu_ps(acc + i + 4));
+        lo = _mm_min_ps(_mm_max_ps(lo, low), high);
+        hi = _mm_min_ps(_mm_max_ps(hi, low), high);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_packs_epi32(_mm_cvtps_epi32(lo), _mm_cvtps_epi32(hi)));
+    }
+    resolveScalar(out + i, acc + i, n - i);
+}
+
+__attribute__((target("avx2")))
+void accumulateAVX2(float* acc, const Sint16* src, std::size_t n, float gain)
+{
+    const __m256 g = _mm256_set1_ps(gain);
+    std::size_t i = 0;
+    for(; i + 16 <= n; i += 16)
+    {
+        const __m256i s = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+        const __m256 lo = _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm256_castsi256_si128(s)));
+        const __m256 hi = _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm256_extracti128_si256(s, 1)));
+        _mm256_storeu_ps(acc + i, _mm256_add_ps(_mm256_loadu_ps(acc + i), _mm256_mul_ps(lo, g)));
+        _mm256_storeu_ps(acc + i + 8, _mm256_add_ps(_mm256_loadu_ps(acc + i + 8), _mm256_mul_ps(hi, g)));
+    }
+    accumulateScalar(acc + i, src + i, n - i, gain);
+}
+
+__attribute__((target("avx2")))
+void resolveAVX2(Sint16* out, const float* acc, std::size_t n)
+{
+    const __m256 low = _mm256_set1_ps(sampleMin);
+    const __m256 high = _mm256_set1_ps(sampleMax);
+    std::size_t i = 0;
+    for(; i + 8 <= n; i += 8)
+    {
+        const __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(out + i));
+        __m256 v = _mm256_add_ps(_mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(s)), _mm256_loadu_ps(acc + i));
+        v = _mm256_min_ps(_mm256_max_ps(v, low), high);
+        const __m256i r = _mm256_cvtps_epi32(v);
+        // packs works per 128 bit lane, packing the halves keeps the order
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i),
+            _mm_packs_epi32(_mm256_castsi256_si128(r), _mm256_extracti128_si256(r, 1)));
+    }
+    resolveScalar(out + i, acc + i, n - i);
+}
+
+#endif
+
+const MixKernels scalarKernels{"scalar", accumulateScalar, resolveScalar};
+#ifdef MIXER_X86
+const MixKernels sseKernels{"sse4.1", accumulateSSE, resolveSSE};
+const MixKernels avx2Kernels{"avx2", accumulateAVX2, resolveAVX2};
+#endif
+
+std::uint64_t nowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+}
+
+const MixKernels& mixKernels()
+{
+    static const MixKernels& choice = []() -> const MixKernels& {
+#ifdef MIXER_X86
+        if ( SDL_HasAVX2() )
+            return avx2Kernels;
+        if ( SDL_HasSSE41() )
+            return sseKernels;
+#endif
+        return scalarKernels;
+    }();
+    return choice;
+}
+
+std::vector<const MixKernels*> availableMixKernels()
+{
+    std::vector<const MixKernels*> kernels{&scalarKernels};
+#ifdef MIXER_X86
+    if ( SDL_HasSSE41() )
+        kernels.push_back(&sseKernels);
+    if ( SDL_HasAVX2() )
+        kernels.push_back(&avx2Kernels);
+#endif
+    return kernels;
+}
+
+Mixer::Mixer(std::size_t maxVoices, const MixKernels& kernels):
+    m_kernels(kernels), m_frequency(mixerFrequency), m_channels(mixerChannels),
+    m_ring(ringSize), m_slots(std::max<std::size_t>(maxVoices, 1))
+{
+    // popped from the back, so the first voices are handed out first
+    for(auto i = static_cast<std::uint32_t>(m_slots.size()); i > 0; i--)
+        m_freeSlots.push_back(i - 1);
+    m_accumulator.resize(static_cast<std::size_t>(mixerChunkSize) * mixerChannels);
+}
+
+Mixer::~Mixer()
+{
+    uninstall();
+}
+
+bool Mixer::install()
+{
+    int frequency = 0;
+    Uint16 format = 0;
+    int channels = 0;
+    if ( 0 == Mix_QuerySpec( &frequency, &format, &channels ) )
+    {
+        std::cerr << "Unable to install the mixer, audio isn't open! SDL_mixer Error: " << Mix_GetError() << std::endl;
+        return false;
+    }
+    if ( AUDIO_S16SYS != format )
+    {
+        std::cerr << "Unable to install the mixer, device format " << std::hex << format << std::dec
+                  << " isn't signed 16 bit" << std::endl;
+        return false;
+    }
+
+    m_frequency = frequency;
+    m_channels = channels;
+    m_lastCallbackNs = 0;
+    Mix_SetPostMix( &Mixer::callback, this );
+    m_installed = true;
+    return true;
+}
+
+void Mixer::uninstall()
+{
+    if ( !m_installed )
+        return;
+    // SDL_mixer swaps the hook under the audio lock: once this returns the callback is neither running nor called again
+    Mix_SetPostMix( NULL, NULL );
+    m_installed = false;
+}
+
+bool Mixer::push(const Command& command)
+{
+    const std::size_t head = m_head.load(std::memory_order_relaxed);
+    if ( head - m_tail.load(std::memory_order_acquire) == ringSize )
+    {
+        m_overflows.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    m_ring[head % ringSize] = command;
+    m_head.store(head + 1, std::memory_order_release);
+    return true;
+}
+
+Mixer::Voice Mixer::play(const Mix_Chunk* chunk, float volume, int priority, int loops)
+{
+    if ( NULL == chunk || NULL == chunk->abuf || chunk->alen < sizeof(Sint16) )
+        return 0;
+
+    const Voice voice = m_nextVoice++;
+    if ( 0 == m_nextVoice )
+        m_nextVoice = 1;
+    if ( !push(Command{Op::Play, voice, chunk, std::clamp(volume, 0.0f, 1.0f), priority, loops}) )
+        return 0;
+    return voice;
+}
+
+void Mixer::stop(Voice voice)
+{
+    if ( voice )
+        push(Command{Op::Stop, voice, nullptr, 0, 0, 0});
+}
+
+void Mixer::setVolume(Voice voice, float volume)
+{
+    if ( voice )
+        push(Command{Op::Volume, voice, nullptr, std::clamp(volume, 0.0f, 1.0f), 0, 0});
+}
+
+void Mixer::setMasterVolume(float volume)
+{
+    push(Command{Op::MasterVolume, 0, nullptr, std::clamp(volume, 0.0f, 1.0f), 0, 0});
+}
+
+void Mixer::stopAll()
+{
+    push(Command{Op::StopAll, 0, nullptr, 0, 0, 0});
+}
+
+void Mixer::release(const Mix_Chunk& chunk)
+{
+    const bool installed = m_installed;
+    uninstall();
+
+    // the audio thread is out of the way: apply what is queued here, a pending play of the chunk included
+    const std::size_t head = m_head.load(std::memory_order_acquire);
+    std::size_t tail = m_tail.load(std::memory_order_relaxed);
+    for(; tail != head; tail++)
+        apply(m_ring[tail % ringSize]);
+    m_tail.store(tail, std::memory_order_release);
+
+    for(Slot& slot : m_slots)
+        if ( slot.voice && slot.chunk == &chunk )
+            freeSlot(slot);
+    m_activeShared.store(m_slots.size() - m_freeSlots.size(), std::memory_order_relaxed);
+
+    if ( installed )
+        install();
+}
+
+Mixer::Slot* Mixer::find(Voice voice)
+{
+    for(Slot& slot : m_slots)
+        if ( slot.voice == voice )
+            return &slot;
+    return nullptr;
+}
+
+void Mixer::freeSlot(Slot& slot)
+{
+    slot.voice = 0;
+    slot.chunk = nullptr;
+    m_freeSlots.push_back(static_cast<std::uint32_t>(&slot - m_slots.data()));
+}
+
+void Mixer::start(const Command& command)
+{
+    Slot* slot = nullptr;
+    if ( !m_freeSlots.empty() )
+    {
+        slot = &m_slots[m_freeSlots.back()];
+        m_freeSlots.pop_back();
+    }
+    else
+    {
+        slot = &*std::min_element(m_slots.begin(), m_slots.end(), [](const Slot& a, const Slot& b) {
+            return a.priority != b.priority ? a.priority < b.priority : a.started < b.started;
+        });
+        if ( slot->priority > command.priority )
+        {
+            m_drops.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        m_steals.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    slot->voice = command.voice;
+    slot->chunk = command.chunk;
+    slot->samples = reinterpret_cast<const Sint16*>(command.chunk->abuf);
+    slot->length = command.chunk->alen / sizeof(Sint16);
+    slot->position = 0;
+    slot->volume = command.volume;
+    slot->priority = command.priority;
+    slot->loops = command.loops;
+    slot->started = m_started++;
+}
+
+void Mixer::apply(const Command& command)
+{
+    switch ( command.op )
+    {
+        case Op::Play:
+            start(command);
+            break;
+        case Op::Stop:
+            if ( Slot* slot = find(command.voice) )
+                freeSlot(*slot);
+            break;
+        case Op::Volume:
+            if ( Slot* slot = find(command.voice) )
+                slot->volume = command.volume;
+            break;
+        case Op::MasterVolume:
+            m_masterVolume = command.volume;
+            break;
+        case Op::StopAll:
+            for(Slot& slot : m_slots)
+                if ( slot.voice )
+                    freeSlot(slot);
+            break;
+    }
+}
+
+void Mixer::callback(void* mixer, Uint8* stream, int len)
+{
+    static_cast<Mixer*>(mixer)->mix(stream, len);
+}
+
+void Mixer::mix(Uint8* stream, int len)
+{
+    const std::uint64_t startNs = nowNs();
+
+    const std::size_t head = m_head.load(std::memory_order_acquire);
+    std::size_t tail = m_tail.load(std::memory_order_relaxed);
+    for(; tail != head; tail++)
+        apply(m_ring[tail % ringSize]);
+    m_tail.store(tail, std::memory_order_release);
+
+    const std::size_t n = static_cast<std::size_t>(len) / sizeof(Sint16);
+    const std::size_t active = m_slots.size() - m_freeSlots.size();
+    if ( active > 0 )
+    {
+        // only grows if the device asks for more than the chunk size it was opened with
+        if ( m_accumulator.size() < n )
+            m_accumulator.resize(n);
+        float* acc = m_accumulator.data();
+        std::fill(acc, acc + n, 0.0f);
+
+        for(Slot& slot : m_slots)
+        {
+            if ( !slot.voice )
+                continue;
+
+            const float gain = slot.volume * m_masterVolume;
+            std::size_t done = 0;
+            while ( done < n )
+            {
+                const std::size_t count = std::min(n - done, slot.length - slot.position);
+                if ( gain > 0.0f )
+                    m_kernels.accumulateS16(acc + done, slot.samples + slot.position, count, gain);
+                done += count;
+                slot.position += count;
+                if ( slot.position < slot.length )
+                    continue;
+                if ( 0 == slot.loops )
+                {
+                    freeSlot(slot);
+                    break;
+                }
+                if ( slot.loops > 0 )
+                    slot.loops--;
+                slot.position = 0;
+            }
+        }
+        m_kernels.resolveS16(reinterpret_cast<Sint16*>(stream), acc, n);
+    }
+
+    const std::size_t playing = m_slots.size() - m_freeSlots.size();
+    m_activeShared.store(playing, std::memory_order_relaxed);
+    if ( active > m_peakVoices.load(std::memory_order_relaxed) )
+        m_peakVoices.store(active, std::memory_order_relaxed);
+
+    const std::uint64_t endNs = nowNs();
+    const std::uint64_t mixNs = endNs - startNs;
+    const std::uint64_t periodNs = n / std::max(m_channels, 1) * 1000000000ull / std::max(m_frequency, 1);
+    bool late = false;
+    if ( m_lastCallbackNs )
+    {
+        const std::uint64_t interval = startNs - m_lastCallbackNs;
+        late = interval > 2 * periodNs;
+        m_intervals.fetch_add(1, std::memory_order_relaxed);
+        m_jitterNs.fetch_add(interval > periodNs ? interval - periodNs : periodNs - interval, std::memory_order_relaxed);
+        if ( interval > m_worstIntervalNs.load(std::memory_order_relaxed) )
+            m_worstIntervalNs.store(interval, std::memory_order_relaxed);
+    }
+    if ( mixNs > periodNs || late )
+        m_underruns.fetch_add(1, std::memory_order_relaxed);
+    m_lastCallbackNs = startNs;
+    m_periodNs.store(periodNs, std::memory_order_relaxed);
+
+    m_callbacks.fetch_add(1, std::memory_order_relaxed);
+    m_mixNs.fetch_add(mixNs, std::memory_order_relaxed);
+    if ( mixNs > m_worstMixNs.load(std::memory_order_relaxed) )
+        m_worstMixNs.store(mixNs, std::memory_order_relaxed);
+}
+
+Mixer::Stats Mixer::stats() const noexcept
+{
+    Stats stats;
+    stats.callbacks = m_callbacks.load(std::memory_order_relaxed);
+    stats.mixMs = m_mixNs.load(std::memory_order_relaxed) / 1e6;
+    stats.worstMixMs = m_worstMixNs.load(std::memory_order_relaxed) / 1e6;
+    stats.underruns = m_underruns.load(std::memory_order_relaxed);
+    stats.periodMs = m_periodNs.load(std::memory_order_relaxed) / 1e6;
+    const std::size_t intervals = m_intervals.load(std::memory_order_relaxed);
+    stats.jitterMs = intervals ? m_jitterNs.load(std::memory_order_relaxed) / 1e6 / intervals : 0.0;
+    stats.worstIntervalMs = m_worstIntervalNs.load(std::memory_order_relaxed) / 1e6;
+    stats.steals = m_steals.load(std::memory_order_relaxed);
+    stats.drops = m_drops.load(std::memory_order_relaxed);
+    stats.overflows = m_overflows.load(std::memory_order_relaxed);
+    stats.peakVoices = m_peakVoices.load(std::memory_order_relaxed);
+    return stats;
+}
@@ -0,0 +1,159 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <SDL.h>
+#include <SDL_mixer.h>
+
+#include "music.hpp"
+
+// Kernels over interleaved signed 16 bit samples, the mixer device format
+struct MixKernels
+{
+    const char* name;
+    // acc[i] += src[i] * gain
+    void (*accumulateS16)(float* acc, const Sint16* src, std::size_t n, float gain);
+    // out[i] = out[i] + acc[i], rounded to nearest and saturated
+    void (*resolveS16)(Sint16* out, const float* acc, std::size_t n);
+};
+
+// Fastest kernels this CPU runs: AVX2, SSE4.1 or scalar, picked once at runtime
+const MixKernels& mixKernels();
+
+// Every variant this CPU runs, scalar first; for benchmarks and comparisons
+std::vector<const MixKernels*> availableMixKernels();
+
+// Plays chunks on a fixed set of voices, mixed on top of SDL_mixer's output in its post mix callback.
+// The game thread only queues commands into a lock-free ring; the audio thread applies them at the start of
+// every callback, so neither side ever waits for the other. When all voices are busy a new sound takes over
+// the voice with the lowest priority, the oldest of them if several tie, unless that one outranks it.
+// Chunks must be in the device format (Mix_LoadWAV and packs give that) and outlive the voices playing them,
+// see release().
+class Mixer
+{
+public:
+    // 0 never names a voice, e.g. for a play that was dropped
+    using Voice = std::uint32_t;
+
+    struct Stats
+    {
+        std::size_t callbacks{0};
+        double mixMs{0};            // time spent in the callback, all callbacks together
+        double worstMixMs{0};
+        std::size_t underruns{0};   // callbacks that took longer than the audio they produced, or came a period late
+        double periodMs{0};         // audio per callback, what the callbacks should be apart
+        double jitterMs{0};         // average distance of the time between callbacks from the period
+        double worstIntervalMs{0};  // longest time between two callbacks
+        std::size_t steals{0};      // voices cut off for a new sound
+        std::size_t drops{0};       // plays refused, every voice outranked them
+        std::size_t overflows{0};   // commands lost to a full ring
+        std::size_t peakVoices{0};
+    };
+
+    explicit Mixer(std::size_t maxVoices = 256, const MixKernels& kernels = mixKernels());
+    // Uninstalls first
+    ~Mixer();
+
+    Mixer(const Mixer&) = delete;
+    Mixer& operator=(const Mixer&) = delete;
+
+    // Hooks into the opened mixer device; false if its format isn't signed 16 bit
+    bool install();
+    void uninstall();
+
+    // Game thread only. loops as for Mix_PlayChannel, -1 forever; volume 0..1; larger priorities win.
+    Voice play(const Mix_Chunk* chunk, float volume = 1.0f, int priority = 0, int loops = 0);
+    void stop(Voice voice);
+    void setVolume(Voice voice, float volume);
+    void setMasterVolume(float volume);
+    void stopAll();
+
+    // Stops every voice playing chunk before returning, so its samples can be freed or replaced.
+    // Briefly uninstalls to know the callback isn't running, so it is meant for rare events like a reload.
+    void release(const Mix_Chunk& chunk);
+
+    // The callback body: applies queued commands and mixes the voices onto len bytes of stream.
+    // Called on the audio thread once installed; usable directly for offline mixing when not installed.
+    void mix(Uint8* stream, int len);
+
+    // Voices playing as of the last callback
+    std::size_t activeVoices() const noexcept {return m_activeShared.load(std::memory_order_relaxed);}
+    // Safe from the game thread while the audio thread is updating them
+    Stats stats() const noexcept;
+    const MixKernels& kernels() const noexcept {return m_kernels;}
+
+private:
+    enum class Op : std::uint8_t { Play, Stop, Volume, MasterVolume, StopAll };
+
+    struct Command
+    {
+        Op op;
+        Voice voice;
+        const Mix_Chunk* chunk;
+        float volume;
+        int priority;
+        int loops;
+    };
+
+    struct Slot
+    {
+        Voice voice{0};  // 0 when free
+        const Mix_Chunk* chunk{nullptr};
+        const Sint16* samples{nullptr};
+        std::size_t length{0};    // in samples, all channels
+        std::size_t position{0};
+        float volume{1.0f};
+        int priority{0};
+        int loops{0};
+        std::uint64_t started{0};
+    };
+
+    static void callback(void* mixer, Uint8* stream, int len);
+
+    bool push(const Command& command);
+    void apply(const Command& command);
+    void start(const Command& command);
+    void freeSlot(Slot& slot);
+    Slot* find(Voice voice);
+
+    const MixKernels& m_kernels;
+    bool m_installed{false};
+    int m_frequency;
+    int m_channels;
+
+    // single producer (game thread), single consumer (audio thread)
+    static constexpr std::size_t ringSize = 1024;
+    std::vector<Command> m_ring;
+    alignas(64) std::atomic<std::size_t> m_head{0};  // next to write, advanced by the game thread
+    alignas(64) std::atomic<std::size_t> m_tail{0};  // next to read, advanced by the audio thread
+
+    // game thread
+    Voice m_nextVoice{1};
+
+    // audio thread
+    std::vector<Slot> m_slots;
+    std::vector<std::uint32_t> m_freeSlots;
+    std::vector<float> m_accumulator;
+    float m_masterVolume{1.0f};
+    std::uint64_t m_started{0};
+    std::uint64_t m_lastCallbackNs{0};
+
+    // written by the audio thread, read by stats()
+    std::atomic<std::size_t> m_activeShared{0};
+    std::atomic<std::size_t> m_callbacks{0};
+    std::atomic<std::uint64_t> m_mixNs{0};
+    std::atomic<std::uint64_t> m_worstMixNs{0};
+    std::atomic<std::size_t> m_underruns{0};
+    std::atomic<std::uint64_t> m_periodNs{0};
+    std::atomic<std::size_t> m_intervals{0};
+    std::atomic<std::uint64_t> m_jitterNs{0};
+    std::atomic<std::uint64_t> m_worstIntervalNs{0};
+    std::atomic<std::size_t> m_steals{0};
+    std::atomic<std::size_t> m_drops{0};
+    std::atomic<std::size_t> m_peakVoices{0};
+    // game thread
+    std::atomic<std::size_t> m_overflows{0};
+};
@@ -1,14 +1,27 @@
 #include <iostream>
 #include <memory>
 #include <filesystem>
+#include <cstring>
+#include <mutex>
 
 #include <SDL.h>
 #include <SDL_mixer.h>
 
 #include "music.hpp"
+#include "profiler.hpp"
+
+namespace
+{
+
+// SDL_mixer's decoders keep shared state (the codec libraries it loads, its error string), so
+// loads from several asset workers go through one at a time
+std::mutex mixLoadMutex;
+
+}
 
 std::unique_ptr<Mix_Music> loadMusic(const std::filesystem::path& path)
 {
+    std::lock_guard lock(mixLoadMutex);
     Mix_Music* music = Mix_LoadMUS( path.c_str() );
     if( music == NULL )
     {
@@ -21,6 +34,8 @@ std::unique_ptr<Mix_Music> loadMusic(const std::filesystem::path& path)
 
 std::unique_ptr<Mix_Chunk> loadChunk(const std::filesystem::path& path)
 {
+    PROFILE_ZONE("loadChunk");
+    std::lock_guard lock(mixLoadMutex);
     Mix_Chunk* chunk = Mix_LoadWAV( path.c_str() );
     if( chunk == NULL )
     {
@@ -30,3 +45,54 @@ std::unique_ptr<Mix_Chunk> loadChunk(const std::filesystem::path& path)
 
     return std::unique_ptr<Mix_Chunk>(chunk);
 }
+
+bool loadPcm(const std::filesystem::path& path, int frequency, Uint16 format, int channels, std::vector<std::uint8_t>& data)
+{
+    SDL_AudioSpec spec;
+    Uint8* buffer = nullptr;
+    Uint32 length = 0;
+    if ( NULL == SDL_LoadWAV( path.c_str(), &spec, &buffer, &length ) )
+    {
+        std::cerr << "Unable to load wave " << path << "! SDL_error: " << SDL_GetError() << std::endl;
+        return false;
+    }
+
+    SDL_AudioCVT cvt;
+    const int needed = SDL_BuildAudioCVT( &cvt, spec.format, spec.channels, spec.freq,
+        format, channels, frequency );
+    if ( needed < 0 )
+    {
+        std::cerr << "Unable to convert " << path << "! SDL_error: " << SDL_GetError() << std::endl;
+        SDL_FreeWAV( buffer );
+        return false;
+    }
+
+    if ( 0 == needed )
+    {
+        data.assign(buffer, buffer + length);
+        SDL_FreeWAV( buffer );
+        return true;
+    }
+
+    data.resize(static_cast<std::size_t>(length) * cvt.len_mult);
+    std::memcpy(data.data(), buffer, length);
+    SDL_FreeWAV( buffer );
+
+    cvt.buf = data.data();
+    cvt.len = length;
+    if ( SDL_ConvertAudio( &cvt ) < 0 )
+    {
+        std::cerr << "Unable to convert " << path << "! SDL_error: " << SDL_GetError() << std::endl;
+        return false;
+    }
+    data.resize(cvt.len_cvt);
+    return true;
+}
+
+std::optional<AudioProfile> findAudioProfile(std::string_view name)
+{
+    for(const AudioProfile& profile : audioProfiles)
+        if ( name == profile.name )
+            return profile;
+    return std::nullopt;
+}
@@ -1,6 +1,11 @@
+#pragma once
+
 #include <iostream>
 #include <memory>
 #include <filesystem>
+#include <optional>
+#include <string_view>
+#include <vector>
 
 #include <SDL.h>
 #include <SDL_mixer.h>
@@ -25,8 +30,42 @@ public:
     }
 };
 
+// Device format the context opens the mixer with
+constexpr int mixerFrequency = 44100;
+constexpr Uint16 mixerFormat = MIX_DEFAULT_FORMAT;
+constexpr int mixerChannels = 2;
+constexpr int mixerChunkSize = 2048;
+
+// Sample rate and buffer size the mixer device is opened with. The buffer is the output latency of every sound:
+// smaller buffers answer a keypress sooner and need the audio thread to be served more reliably.
+struct AudioProfile
+{
+    const char* name;
+    int frequency;
+    int chunkSize;  // sample frames per callback
+
+    double latencyMs() const noexcept {return 1000.0 * chunkSize / frequency;}
+};
+
+constexpr AudioProfile defaultAudioProfile{"safe", mixerFrequency, mixerChunkSize};
+
+// Packs hold PCM at mixerFrequency, profiles at other rates decode their chunks instead.
+// 48 kHz is what most devices run natively, so nothing resamples behind the smallest buffer.
+constexpr AudioProfile audioProfiles[] = {
+    defaultAudioProfile,
+    {"balanced", mixerFrequency, 1024},
+    {"low", mixerFrequency, 512},
+    {"minimal", 48000, 256},
+};
+
+std::optional<AudioProfile> findAudioProfile(std::string_view name);
+
 using MixMusic = std::unique_ptr<Mix_Music>;
 using MixChunk = std::unique_ptr<Mix_Chunk>;
 
+// Safe to call from any thread, the Mix_* loads themselves run one at a time
 std::unique_ptr<Mix_Music> loadMusic(const std::filesystem::path& path);
 std::unique_ptr<Mix_Chunk> loadChunk(const std::filesystem::path& path);
+
+// Decodes a .wav file into raw samples in the given device format, e.g. for Mix_QuickLoad_RAW
+bool loadPcm(const std::filesystem::path& path, int frequency, Uint16 format, int channels, std::vector<std::uint8_t>& data);
@@ -0,0 +1,81 @@
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <SDL.h>
+#include <SDL_image.h>
+
+#include "asset_pack.hpp"
+#include "sound_bank.hpp"
+
+namespace
+{
+
+void usage(const char* program)
+{
+    std::cerr << "Usage: " << program << " OUTPUT [--raw] FILE..." << std::endl
+              << "  images are stored decoded and color keyed, .wav files as PCM in the mixer format," << std::endl
+              << "  everything else and files after --raw (e.g. music) as they are" << std::endl
+              << "  an OUTPUT ending in .bank is a sound bank of .wav files in the mixer format instead" << std::endl;
+}
+
+AssetPack::Kind kindOf(const std::filesystem::path& path)
+{
+    const std::string extension = path.extension().string();
+    if ( ".png" == extension || ".bmp" == extension || ".jpg" == extension )
+        return AssetPack::Kind::Pixels;
+    if ( ".wav" == extension )
+        return AssetPack::Kind::Pcm;
+    return AssetPack::Kind::Raw;
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+    if ( argc < 3 )
+    {
+        usage(argv[0]);
+        return -1;
+    }
+
+    if ( ".bank" == std::filesystem::path(argv[1]).extension() )
+    {
+        const std::vector<std::filesystem::path> sounds(argv + 2, argv + argc);
+        auto bank = loadSoundBank(sounds);
+        if ( !bank || !bank->save(argv[1]) )
+            return -1;
+        std::cout << "Banked " << bank->size() << " sounds, " << bank->bytesResident() / 1024 << " KB into " << argv[1]
+                  << std::endl;
+        return 0;
+    }
+
+    std::vector<AssetPackSource> sources;
+    for(int i = 2; i < argc; i++)
+    {
+        const std::string arg = argv[i];
+        if ( "--raw" == arg && i + 1 < argc )
+            sources.push_back({argv[++i], AssetPack::Kind::Raw});
+        else if ( 0 == arg.compare(0, 2, "--") )
+        {
+            usage(argv[0]);
+            return -1;
+        }
+        else
+            sources.push_back({arg, kindOf(arg)});
+    }
+
+    const int imgFlags = IMG_INIT_PNG;
+    if ( !(IMG_Init( imgFlags ) & imgFlags ) )
+    {
+        std::cerr << "SDL_image could not be initialized! SDL_image Error: " << IMG_GetError() << std::endl;
+        return -1;
+    }
+
+    const bool written = writeAssetPack(argv[1], sources);
+    IMG_Quit();
+    if ( !written )
+        return -1;
+
+    std::cout << "Packed " << sources.size() << " assets into " << argv[1] << std::endl;
+}
@@ -0,0 +1,279 @@
+#include <cassert>
+#include <utility>
+
+#include <SDL.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define PARTICLES_X86 1
+#endif
+
+#include "particles.hpp"
+
+ParticleStore::ParticleStore(const ParticleStore& other)
+{
+    *this = other;
+}
+
+ParticleStore& ParticleStore::operator=(const ParticleStore& other)
+{
+    if ( this == &other )
+        return *this;
+
+    // a copy always owns its arrays
+    m_backing.reset();
+    for(int c = 0; c < ComponentCount; c++)
+        m_owned[c].assign(other.m_data[c], other.m_data[c] + other.m_size);
+    attachOwned();
+    return *this;
+}
+
+ParticleStore::ParticleStore(ParticleStore&& other) noexcept
+{
+    *this = std::move(other);
+}
+
+ParticleStore& ParticleStore::operator=(ParticleStore&& other) noexcept
+{
+    if ( this == &other )
+        return *this;
+
+    // moving a vector keeps its buffer, so the pointers into owned arrays stay valid
+    m_owned = std::move(other.m_owned);
+    m_data = other.m_data;
+    m_size = other.m_size;
+    m_backing = std::move(other.m_backing);
+
+    for(FloatArray& array : other.m_owned)
+        array.clear();
+    other.m_data = Arrays{};
+    other.m_size = 0;
+    return *this;
+}
+
+ParticleStore ParticleStore::borrow(std::shared_ptr<void> backing, const Arrays& arrays, std::size_t n)
+{
+    ParticleStore store;
+    store.m_backing = std::move(backing);
+    store.m_data = arrays;
+    store.m_size = n;
+    return store;
+}
+
+void ParticleStore::makeOwned()
+{
+    if ( !m_backing )
+        return;
+
+    for(int c = 0; c < ComponentCount; c++)
+        m_owned[c].assign(m_data[c], m_data[c] + m_size);
+    m_backing.reset();
+    attachOwned();
+}
+
+void ParticleStore::attachOwned() noexcept
+{
+    for(int c = 0; c < ComponentCount; c++)
+        m_data[c] = m_owned[c].data();
+    m_size = m_owned[X].size();
+}
+
+void ParticleStore::reserve(std::size_t n)
+{
+    makeOwned();
+    for(FloatArray& a : m_owned)
+        a.reserve(n);
+    attachOwned();
+}
+
+void ParticleStore::resize(std::size_t n)
+{
+    makeOwned();
+    for(FloatArray& a : m_owned)
+        a.resize(n);
+    attachOwned();
+}
+
+void ParticleStore::clear() noexcept
+{
+    m_backing.reset();
+    for(FloatArray& a : m_owned)
+        a.clear();
+    attachOwned();
+}
+
+void ParticleStore::push_back(const Ball& b)
+{
+    makeOwned();
+    m_owned[X].push_back(b.p().x());
+    m_owned[Y].push_back(b.p().y());
+    m_owned[VX].push_back(b.v().x());
+    m_owned[VY].push_back(b.v().y());
+    m_owned[R].push_back(b.r());
+    attachOwned();
+}
+
+Ball ParticleStore::ball(std::size_t i) const
+{
+    assert( i < size() );
+    return Ball(vec2(x()[i], y()[i]), r()[i], vec2(vx()[i], vy()[i]));
+}
+
+void ParticleStore::setBall(std::size_t i, const Ball& b)
+{
+    assert( i < size() );
+    x()[i] = b.p().x();
+    y()[i] = b.p().y();
+    vx()[i] = b.v().x();
+    vy()[i] = b.v().y();
+    r()[i] = b.r();
+}
+
+namespace
+{
+
+using IntegrateKernel = void (*)(float*, float*, float*, float*, std::size_t, float, float, float);
+
+inline void integrateOne(float& p, float& v, float dt, float limit)
+{
+    p += v * dt;
+    if ( p > limit )
+    {
+        p = limit;
+        v = -v;
+    }
+    else if ( p < 0 )
+    {
+        p = 0;
+        v = -v;
+    }
+}
+
+void integrateScalar(float* x, float* y, float* vx, float* vy, std::size_t n,
+    float dt, float width, float height)
+{
+    for(std::size_t i = 0; i < n; i++)
+    {
+        integrateOne(x[i], vx[i], dt, width);
+        integrateOne(y[i], vy[i], dt, height);
+    }
+}
+
+#ifdef PARTICLES_X86
+
+__attribute__((target("sse2")))
+inline void reflectSSE(__m128& p, __m128& v, __m128 dt, __m128 limit)
+{
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 sign = _mm_set1_ps(-0.0f);
+
+    p = _mm_add_ps(p, _mm_mul_ps(v, dt));
+    const __m128 out = _mm_or_ps(_mm_cmpgt_ps(p, limit), _mm_cmplt_ps(p, zero));
+    p = _mm_min_ps(_mm_max_ps(p, zero), limit);
+    v = _mm_xor_ps(v, _mm_and_ps(out, sign));
+}
+
+__attribute__((target("sse2")))
+void integrateSSE(float* x, float* y, float* vx, float* vy, std::size_t n,
+    float dt, float width, float height)
+{
+    const __m128 vdt = _mm_set1_ps(dt);
+    const __m128 vw = _mm_set1_ps(width);
+    const __m128 vh = _mm_set1_ps(height);
+
+    std::size_t i = 0;
+    for(; i + 4 <= n; i += 4)
+    {
+        __m128 px = _mm_loadu_ps(x + i);
+        __m128 py = _mm_loadu_ps(y + i);
+        __m128 pvx = _mm_loadu_ps(vx + i);
+        __m128 pvy = _mm_loadu_ps(vy + i);
+
+        reflectSSE(px, pvx, vdt, vw);
+        reflectSSE(py, pvy, vdt, vh);
+
+        _mm_storeu_ps(x + i, px);
+        _mm_storeu_ps(y + i, py);
+        _mm_storeu_ps(vx + i, pvx);
+        _mm_storeu_ps(vy + i, pvy);
+    }
+
+    integrateScalar(x + i, y + i, vx + i, vy + i, n - i, dt, width, height);
+}
+
+__attribute__((target("avx2")))
+inline void reflectAVX2(__m256& p, __m256& v, __m256 dt, __m256 limit)
+{
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 sign = _mm256_set1_ps(-0.0f);
+
+    p = _mm256_add_ps(p, _mm256_mul_ps(v, dt));
+    const __m256 out = _mm256_or_ps(_mm256_cmp_ps(p, limit, _CMP_GT_OQ), _mm256_cmp_ps(p, zero, _CMP_LT_OQ));
+    p = _mm256_min_ps(_mm256_max_ps(p, zero), limit);
+    v = _mm256_xor_ps(v, _mm256_and_ps(out, sign));
+}
+
+__attribute__((target("avx2")))
+void integrateAVX2(float* x, float* y, float* vx, float* vy, std::size_t n,
+    float dt, float width, float height)
+{
+    const __m256 vdt = _mm256_set1_ps(dt);
+    const __m256 vw = _mm256_set1_ps(width);
+    const __m256 vh = _mm256_set1_ps(height);
+
+    std::size_t i = 0;
+    for(; i + 8 <= n; i += 8)
+    {
+        __m256 px = _mm256_loadu_ps(x + i);
+        __m256 py = _mm256_loadu_ps(y + i);
+        __m256 pvx = _mm256_loadu_ps(vx + i);
+        __m256 pvy = _mm256_loadu_ps(vy + i);
+
+        reflectAVX2(px, pvx, vdt, vw);
+        reflectAVX2(py, pvy, vdt, vh);
+
+        _mm256_storeu_ps(x + i, px);
+        _mm256_storeu_ps(y + i, py);
+        _mm256_storeu_ps(vx + i, pvx);
+        _mm256_storeu_ps(vy + i, pvy);
+    }
+
+    integrateSSE(x + i, y + i, vx + i, vy + i, n - i, dt, width, height);
+}
+
+#endif
+
+struct KernelChoice
+{
+    IntegrateKernel kernel;
+    const char* name;
+};
+
+const KernelChoice& chooseKernel()
+{
+    static const KernelChoice choice = []() -> KernelChoice {
+#ifdef PARTICLES_X86
+        if ( SDL_HasAVX2() )
+            return {integrateAVX2, "avx2"};
+        if ( SDL_HasSSE2() )
+            return {integrateSSE, "sse2"};
+#endif
+        return {integrateScalar, "scalar"};
+    }();
+    return choice;
+}
+
+}
+
+void integrateAndReflect(ParticleStore& store, std::size_t begin, std::size_t end,
+    float dt, float width, float height)
+{
+    assert( begin <= end && end <= store.size() );
+    chooseKernel().kernel(store.x() + begin, store.y() + begin, store.vx() + begin, store.vy() + begin,
+        end - begin, dt, width, height);
+}
+
+const char* integrateKernelName()
+{
+    return chooseKernel().name;
+}
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <vector>
+
+#include "ball.hpp"
+
+template<typename T, std::size_t Alignment>
+class AlignedAllocator
+{
+public:
+    using value_type = T;
+
+    template<typename U>
+    struct rebind { using other = AlignedAllocator<U, Alignment>; };
+
+    AlignedAllocator() noexcept = default;
+
+    template<typename U>
+    AlignedAllocator(const AlignedAllocator<U, Alignment>&) noexcept {}
+
+    T* allocate(std::size_t n)
+    {
+        const std::size_t bytes = (n * sizeof(T) + Alignment - 1) / Alignment * Alignment;
+        void* ptr = std::aligned_alloc(Alignment, bytes);
+        if ( nullptr == ptr )
+            throw std::bad_alloc();
+        return static_cast<T*>(ptr);
+    }
+
+    void deallocate(T* ptr, std::size_t) noexcept { std::free(ptr); }
+
+    template<typename U>
+    bool operator==(const AlignedAllocator<U, Alignment>&) const noexcept { return true; }
+    template<typename U>
+    bool operator!=(const AlignedAllocator<U, Alignment>&) const noexcept { return false; }
+};
+
+// 32 bytes is one AVX register, so every array starts on a vector boundary
+using FloatArray = std::vector<float, AlignedAllocator<float, 32>>;
+
+// Structure-of-arrays storage for balls: every component lives in its own
+// contiguous array so the update kernel can process 4/8 balls per instruction.
+// The arrays are either owned, or borrowed from memory kept alive by a backing
+// object (e.g. a mapped snapshot file); growing a borrowed store copies it first.
+class ParticleStore
+{
+public:
+    enum Component { X, Y, VX, VY, R, ComponentCount };
+    using Arrays = std::array<float*, ComponentCount>;
+
+    ParticleStore() = default;
+    ParticleStore(const ParticleStore& other);
+    // A moved-from store is empty
+    ParticleStore(ParticleStore&& other) noexcept;
+    ParticleStore& operator=(const ParticleStore& other);
+    ParticleStore& operator=(ParticleStore&& other) noexcept;
+
+    // Uses the arrays in place; backing is held for as long as the store refers to them
+    static ParticleStore borrow(std::shared_ptr<void> backing, const Arrays& arrays, std::size_t n);
+
+    std::size_t size() const noexcept {return m_size;}
+    bool empty() const noexcept {return 0 == m_size;}
+    bool borrowed() const noexcept {return static_cast<bool>(m_backing);}
+
+    void reserve(std::size_t n);
+    void resize(std::size_t n);
+    void clear() noexcept;
+
+    void push_back(const Ball& b);
+
+    // Per-object view for callers that still think in terms of Ball
+    Ball ball(std::size_t i) const;
+    void setBall(std::size_t i, const Ball& b);
+
+    float* x() noexcept {return m_data[X];}
+    float* y() noexcept {return m_data[Y];}
+    float* vx() noexcept {return m_data[VX];}
+    float* vy() noexcept {return m_data[VY];}
+    float* r() noexcept {return m_data[R];}
+
+    const float* x() const noexcept {return m_data[X];}
+    const float* y() const noexcept {return m_data[Y];}
+    const float* vx() const noexcept {return m_data[VX];}
+    const float* vy() const noexcept {return m_data[VY];}
+    const float* r() const noexcept {return m_data[R];}
+
+    const float* component(Component c) const noexcept {return m_data[c];}
+
+private:
+    void makeOwned();
+    void attachOwned() noexcept;
+
+    std::array<FloatArray, ComponentCount> m_owned;
+    Arrays m_data{};
+    std::size_t m_size{0};
+    std::shared_ptr<void> m_backing;
+};
+
+// Moves balls [begin, end) by v*dt and reflects them off the [0, width] x [0, height] walls.
+// Picks AVX2, SSE2 or scalar code at runtime depending on the CPU.
+void integrateAndReflect(ParticleStore& store, std::size_t begin, std::size_t end,
+    float dt, float width, float height);
+
+inline void integrateAndReflect(ParticleStore& store, float dt, float width, float height)
+{
+    integrateAndReflect(store, 0, store.size(), dt, width, height);
+}
+
+const char* integrateKernelName();
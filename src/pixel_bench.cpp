@@ -0,0 +1,193 @@
+#include <iostream>
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <functional>
+
+#include <SDL.h>
+#include <SDL_image.h>
+
+#include "surface.hpp"
+#include "pixel_convert.hpp"
+
+namespace
+{
+
+using clock = std::chrono::steady_clock;
+
+struct Result
+{
+    const char* source;
+    const char* operation;
+    const char* path;
+    int width;
+    int height;
+    double bestMs;
+    // the SDL path keeps the RGB of keyed pixels, it is not compared
+    const char* matchesScalar;
+};
+
+// Best of several runs, the first one also pays for page faults
+double bestMilliseconds(int iterations, const std::function<void()>& run)
+{
+    double best = 1e300;
+    for(int i = 0; i < iterations; i++)
+    {
+        const auto start = clock::now();
+        run();
+        best = std::min(best, std::chrono::duration<double, std::milli>(clock::now() - start).count());
+    }
+    return best;
+}
+
+bool samePixels(const SDL_Surface* a, const SDL_Surface* b)
+{
+    if ( a->w != b->w || a->h != b->h )
+        return false;
+    for(int y = 0; y < a->h; y++)
+    {
+        if ( 0 != std::memcmp(static_cast<const Uint8*>(a->pixels) + y * a->pitch,
+                              static_cast<const Uint8*>(b->pixels) + y * b->pitch, a->w * 4) )
+            return false;
+    }
+    return true;
+}
+
+std::unique_ptr<SDL_Surface> scaled(SDL_Surface* image, Uint32 format, int scale)
+{
+    std::unique_ptr<SDL_Surface> surface(SDL_CreateRGBSurfaceWithFormat( 0, image->w * scale, image->h * scale,
+        SDL_BITSPERPIXEL(format), format ));
+    if ( !surface )
+    {
+        std::cerr << "Unable to create surface! SDL_error: " << SDL_GetError() << std::endl;
+        return nullptr;
+    }
+    SDL_SetSurfaceBlendMode( image, SDL_BLENDMODE_NONE );
+    if ( 0 != SDL_BlitScaled( image, NULL, surface.get(), NULL ) )
+    {
+        std::cerr << "Unable to scale image! SDL_error: " << SDL_GetError() << std::endl;
+        return nullptr;
+    }
+    SDL_SetColorKey( surface.get(), SDL_TRUE, SDL_MapRGB( surface->format, 0xFF, 0xFF, 0xFF ) );
+    return surface;
+}
+
+void runSource(const char* name, SDL_Surface* source, int iterations, std::vector<Result>& results)
+{
+    const int w = source->w;
+    const int h = source->h;
+
+    // what loading did before the kernels: SDL turns the color key into alpha while converting
+    results.push_back({name, "convert+key", "sdl", w, h, bestMilliseconds(iterations, [&]() {
+        std::unique_ptr<SDL_Surface>(SDL_ConvertSurfaceFormat( source, SDL_PIXELFORMAT_ARGB8888, 0 ));
+    }), "-"});
+
+    const auto kernels = availablePixelKernels();
+    auto reference = convertToArgb8888(source, *kernels.front());
+    auto referencePremultiplied = convertToArgb8888(source, *kernels.front());
+    if ( !reference || !referencePremultiplied )
+        return;
+    for(int y = 0; y < h; y++)
+        kernels.front()->premultiplyAlpha(reinterpret_cast<std::uint32_t*>(
+            static_cast<Uint8*>(referencePremultiplied->pixels) + y * referencePremultiplied->pitch), w);
+
+    for(const PixelKernels* k : kernels)
+    {
+        std::unique_ptr<SDL_Surface> converted;
+        results.push_back({name, "convert+key", k->name, w, h, bestMilliseconds(iterations, [&]() {
+            converted = convertToArgb8888(source, *k);
+        }), converted && samePixels(converted.get(), reference.get()) ? "yes" : "no"});
+
+        // premultiplying twice changes the pixels, so every run starts from a fresh copy
+        auto premultiplied = convertToArgb8888(source, *k);
+        std::vector<std::uint32_t> original(static_cast<std::uint32_t*>(premultiplied->pixels),
+            static_cast<std::uint32_t*>(premultiplied->pixels) + premultiplied->pitch / 4 * h);
+        double best = 1e300;
+        for(int i = 0; i < iterations; i++)
+        {
+            std::copy(original.begin(), original.end(), static_cast<std::uint32_t*>(premultiplied->pixels));
+            const auto start = clock::now();
+            k->premultiplyAlpha(static_cast<std::uint32_t*>(premultiplied->pixels), original.size());
+            best = std::min(best, std::chrono::duration<double, std::milli>(clock::now() - start).count());
+        }
+        results.push_back({name, "premultiply", k->name, w, h, best,
+            samePixels(premultiplied.get(), referencePremultiplied.get()) ? "yes" : "no"});
+    }
+}
+
+void printCSV(std::ostream& os, const std::vector<Result>& results)
+{
+    os << "source,operation,path,width,height,best_ms,mpixels_per_s,matches_scalar\n";
+    for(const Result& r : results)
+        os << r.source << ',' << r.operation << ',' << r.path << ',' << r.width << ',' << r.height << ','
+           << r.bestMs << ',' << (double(r.width) * r.height / 1000.0 / r.bestMs) << ',' << r.matchesScalar << '\n';
+}
+
+void usage(const char* name)
+{
+    std::cerr << "Usage: " << name << " [--image PATH] [--scale N] [--iterations N]\n"
+              << "  Scales the image (default media/tree.png) up N times (default 8) into RGB24 and RGBA32 surfaces\n"
+              << "  and times their conversion to ARGB8888 by SDL and by each pixel kernel set this CPU runs.\n";
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+    std::string imagePath = "media/tree.png";
+    int scale = 8;
+    int iterations = 20;
+
+    try
+    {
+        for(int i = 1; i < argc; i++)
+        {
+            const std::string arg = argv[i];
+            if ( "--image" == arg && i + 1 < argc )
+                imagePath = argv[++i];
+            else if ( "--scale" == arg && i + 1 < argc )
+                scale = std::max(1, std::stoi(argv[++i]));
+            else if ( "--iterations" == arg && i + 1 < argc )
+                iterations = std::max(1, std::stoi(argv[++i]));
+            else
+            {
+                usage(argv[0]);
+                return -1;
+            }
+        }
+    }
+    catch (const std::exception&)
+    {
+        usage(argv[0]);
+        return -1;
+    }
+
+    if ( 0 != SDL_Init( 0 ) )
+    {
+        std::cerr << "SDL could not initialize! SDL_Error: " << SDL_GetError() << std::endl;
+        return -1;
+    }
+
+    std::unique_ptr<SDL_Surface> image(IMG_Load( imagePath.c_str() ));
+    if ( !image )
+    {
+        std::cerr << "Unable to load " << imagePath << "! IMG_error: " << IMG_GetError() << std::endl;
+        return -1;
+    }
+
+    std::cerr << "pixel kernels: " << pixelKernels().name << std::endl;
+
+    std::vector<Result> results;
+    auto rgb24 = scaled(image.get(), SDL_PIXELFORMAT_RGB24, scale);
+    auto rgba32 = scaled(image.get(), SDL_PIXELFORMAT_RGBA32, scale);
+    if ( !rgb24 || !rgba32 )
+        return -1;
+    runSource("rgb24", rgb24.get(), iterations, results);
+    runSource("rgba32", rgba32.get(), iterations, results);
+
+    printCSV(std::cout, results);
+
+    SDL_Quit();
+}
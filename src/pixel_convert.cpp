@@ -0,0 +1,348 @@
+#include <iostream>
+#include <cstring>
+
+#include <SDL.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define PIXELS_X86 1
+#endif
+
+#include "pixel_convert.hpp"
+
+namespace
+{
+
+constexpr std::uint32_t opaque = 0xFF000000;
+constexpr std::uint32_t rgbMask = 0x00FFFFFF;
+
+// c * a / 255 rounded, exact for all 8 bit inputs
+inline std::uint32_t multiplyChannel(std::uint32_t c, std::uint32_t a)
+{
+    const std::uint32_t t = c * a + 128;
+    return (t + (t >> 8)) >> 8;
+}
+
+void rgb24Scalar(const std::uint8_t* src, std::uint32_t* dst, std::size_t n)
+{
+    for(std::size_t i = 0; i < n; i++, src += 3)
+        dst[i] = opaque | std::uint32_t(src[0]) << 16 | std::uint32_t(src[1]) << 8 | src[2];
+}
+
+void rgba32Scalar(const std::uint8_t* src, std::uint32_t* dst, std::size_t n)
+{
+    for(std::size_t i = 0; i < n; i++, src += 4)
+        dst[i] = std::uint32_t(src[3]) << 24 | std::uint32_t(src[0]) << 16 | std::uint32_t(src[1]) << 8 | src[2];
+}
+
+void colorKeyScalar(std::uint32_t* pixels, std::size_t n, std::uint32_t key)
+{
+    key &= rgbMask;
+    for(std::size_t i = 0; i < n; i++)
+    {
+        if ( (pixels[i] & rgbMask) == key )
+            pixels[i] = 0;
+    }
+}
+
+void premultiplyScalar(std::uint32_t* pixels, std::size_t n)
+{
+    for(std::size_t i = 0; i < n; i++)
+    {
+        const std::uint32_t p = pixels[i];
+        const std::uint32_t a = p >> 24;
+        if ( 0xFF == a )
+            continue;
+        pixels[i] = a << 24 | multiplyChannel((p >> 16) & 0xFF, a) << 16
+            | multiplyChannel((p >> 8) & 0xFF, a) << 8 | multiplyChannel(p & 0xFF, a);
+    }
+}
+
+#ifdef PIXELS_X86
+
+// pshufb needs SSSE3; SDL can only report SSE4.1, which implies it
+
+// bytes R G B of four pixels to B G R 0, alpha is or'ed in afterwards
+__attribute__((target("sse4.1")))
+inline __m128i rgb24Shuffle()
+{
+    return _mm_setr_epi8(2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1);
+}
+
+__attribute__((target("sse4.1")))
+inline __m128i rgba32Shuffle()
+{
+    return _mm_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+}
+
+__attribute__((target("sse4.1")))
+void rgb24SSE(const std::uint8_t* src, std::uint32_t* dst, std::size_t n)
+{
+    const __m128i shuffle = rgb24Shuffle();
+    const __m128i alpha = _mm_set1_epi32(static_cast<int>(opaque));
+
+    // four pixels are 12 bytes but the load takes 16, the last ones are left to the scalar loop
+    std::size_t i = 0;
+    for(; i + 6 <= n; i += 4)
+    {
+        const __m128i rgb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 3));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_or_si128(_mm_shuffle_epi8(rgb, shuffle), alpha));
+    }
+
+    rgb24Scalar(src + i * 3, dst + i, n - i);
+}
+
+__attribute__((target("sse4.1")))
+void rgba32SSE(const std::uint8_t* src, std::uint32_t* dst, std::size_t n)
+{
+    const __m128i shuffle = rgba32Shuffle();
+
+    std::size_t i = 0;
+    for(; i + 4 <= n; i += 4)
+    {
+        const __m128i rgba = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 4));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_shuffle_epi8(rgba, shuffle));
+    }
+
+    rgba32Scalar(src + i * 4, dst + i, n - i);
+}
+
+__attribute__((target("sse4.1")))
+void colorKeySSE(std::uint32_t* pixels, std::size_t n, std::uint32_t key)
+{
+    const __m128i mask = _mm_set1_epi32(static_cast<int>(rgbMask));
+    const __m128i vkey = _mm_set1_epi32(static_cast<int>(key & rgbMask));
+
+    std::size_t i = 0;
+    for(; i + 4 <= n; i += 4)
+    {
+        __m128i* p = reinterpret_cast<__m128i*>(pixels + i);
+        const __m128i v = _mm_loadu_si128(p);
+        const __m128i keyed = _mm_cmpeq_epi32(_mm_and_si128(v, mask), vkey);
+        _mm_storeu_si128(p, _mm_andnot_si128(keyed, v));
+    }
+
+    colorKeyScalar(pixels + i, n - i, key);
+}
+
+// two pixels widened to 16 bit lanes B G R A
+__attribute__((target("sse4.1")))
+inline __m128i premultiplyWide(__m128i x)
+{
+    const __m128i colorLanes = _mm_setr_epi16(-1, -1, -1, 0, -1, -1, -1, 0);
+    const __m128i alphaLane = _mm_setr_epi16(0, 0, 0, 255, 0, 0, 0, 255);
+    const __m128i round = _mm_set1_epi16(128);
+
+    __m128i a = _mm_shufflehi_epi16(_mm_shufflelo_epi16(x, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+    // alpha is multiplied by 255 and so comes out unchanged
+    a = _mm_or_si128(_mm_and_si128(a, colorLanes), alphaLane);
+
+    const __m128i t = _mm_add_epi16(_mm_mullo_epi16(x, a), round);
+    return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+}
+
+__attribute__((target("sse4.1")))
+void premultiplySSE(std::uint32_t* pixels, std::size_t n)
+{
+    const __m128i zero = _mm_setzero_si128();
+
+    std::size_t i = 0;
+    for(; i + 4 <= n; i += 4)
+    {
+        __m128i* p = reinterpret_cast<__m128i*>(pixels + i);
+        const __m128i v = _mm_loadu_si128(p);
+        const __m128i lo = premultiplyWide(_mm_unpacklo_epi8(v, zero));
+        const __m128i hi = premultiplyWide(_mm_unpackhi_epi8(v, zero));
+        _mm_storeu_si128(p, _mm_packus_epi16(lo, hi));
+    }
+
+    premultiplyScalar(pixels + i, n - i);
+}
+
+__attribute__((target("avx2")))
+void rgb24AVX2(const std::uint8_t* src, std::uint32_t* dst, std::size_t n)
+{
+    const __m256i shuffle = _mm256_broadcastsi128_si256(_mm_setr_epi8(2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1));
+    const __m256i alpha = _mm256_set1_epi32(static_cast<int>(opaque));
+
+    // each lane gets four pixels of its own, the second load ends 28 bytes in
+    std::size_t i = 0;
+    for(; i + 10 <= n; i += 8)
+    {
+        const std::uint8_t* s = src + i * 3;
+        const __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s));
+        const __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + 12));
+        const __m256i rgb = _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_or_si256(_mm256_shuffle_epi8(rgb, shuffle), alpha));
+    }
+
+    rgb24SSE(src + i * 3, dst + i, n - i);
+}
+
+__attribute__((target("avx2")))
+void rgba32AVX2(const std::uint8_t* src, std::uint32_t* dst, std::size_t n)
+{
+    const __m256i shuffle = _mm256_broadcastsi128_si256(_mm_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15));
+
+    std::size_t i = 0;
+    for(; i + 8 <= n; i += 8)
+    {
+        const __m256i rgba = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i * 4));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_shuffle_epi8(rgba, shuffle));
+    }
+
+    rgba32SSE(src + i * 4, dst + i, n - i);
+}
+
+__attribute__((target("avx2")))
+void colorKeyAVX2(std::uint32_t* pixels, std::size_t n, std::uint32_t key)
+{
+    const __m256i mask = _mm256_set1_epi32(static_cast<int>(rgbMask));
+    const __m256i vkey = _mm256_set1_epi32(static_cast<int>(key & rgbMask));
+
+    std::size_t i = 0;
+    for(; i + 8 <= n; i += 8)
+    {
+        __m256i* p = reinterpret_cast<__m256i*>(pixels + i);
+        const __m256i v = _mm256_loadu_si256(p);
+        const __m256i keyed = _mm256_cmpeq_epi32(_mm256_and_si256(v, mask), vkey);
+        _mm256_storeu_si256(p, _mm256_andnot_si256(keyed, v));
+    }
+
+    colorKeySSE(pixels + i, n - i, key);
+}
+
+__attribute__((target("avx2")))
+inline __m256i premultiplyWideAVX2(__m256i x)
+{
+    const __m256i colorLanes = _mm256_setr_epi16(-1, -1, -1, 0, -1, -1, -1, 0, -1, -1, -1, 0, -1, -1, -1, 0);
+    const __m256i alphaLane = _mm256_setr_epi16(0, 0, 0, 255, 0, 0, 0, 255, 0, 0, 0, 255, 0, 0, 0, 255);
+    const __m256i round = _mm256_set1_epi16(128);
+
+    __m256i a = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(x, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+    a = _mm256_or_si256(_mm256_and_si256(a, colorLanes), alphaLane);
+
+    const __m256i t = _mm256_add_epi16(_mm256_mullo_epi16(x, a), round);
+    return _mm256_srli_epi16(_mm256_add_epi16(t, _mm256_srli_epi16(t, 8)), 8);
+}
+
+__attribute__((target("avx2")))
+void premultiplyAVX2(std::uint32_t* pixels, std::size_t n)
+{
+    const __m256i zero = _mm256_setzero_si256();
+
+    // unpack and pack work within 128 bit lanes, so the pixels come back in their order
+    std::size_t i = 0;
+    for(; i + 8 <= n; i += 8)
+    {
+        __m256i* p = reinterpret_cast<__m256i*>(pixels + i);
+        const __m256i v = _mm256_loadu_si256(p);
+        const __m256i lo = premultiplyWideAVX2(_mm256_unpacklo_epi8(v, zero));
+        const __m256i hi = premultiplyWideAVX2(_mm256_unpackhi_epi8(v, zero));
+        _mm256_storeu_si256(p, _mm256_packus_epi16(lo, hi));
+    }
+
+    premultiplySSE(pixels + i, n - i);
+}
+
+#endif
+
+const PixelKernels scalarKernels{"scalar", rgb24Scalar, rgba32Scalar, colorKeyScalar, premultiplyScalar};
+#ifdef PIXELS_X86
+const PixelKernels sseKernels{"sse4.1", rgb24SSE, rgba32SSE, colorKeySSE, premultiplySSE};
+const PixelKernels avx2Kernels{"avx2", rgb24AVX2, rgba32AVX2, colorKeyAVX2, premultiplyAVX2};
+#endif
+
+}
+
+const PixelKernels& pixelKernels()
+{
+    static const PixelKernels& choice = []() -> const PixelKernels& {
+#ifdef PIXELS_X86
+        if ( SDL_HasAVX2() )
+            return avx2Kernels;
+        if ( SDL_HasSSE41() )
+            return sseKernels;
+#endif
+        return scalarKernels;
+    }();
+    return choice;
+}
+
+std::vector<const PixelKernels*> availablePixelKernels()
+{
+    std::vector<const PixelKernels*> kernels{&scalarKernels};
+#ifdef PIXELS_X86
+    if ( SDL_HasSSE41() )
+        kernels.push_back(&sseKernels);
+    if ( SDL_HasAVX2() )
+        kernels.push_back(&avx2Kernels);
+#endif
+    return kernels;
+}
+
+std::unique_ptr<SDL_Surface> convertToArgb8888(SDL_Surface* surface, const PixelKernels& kernels)
+{
+    if ( NULL == surface )
+        return nullptr;
+
+    Uint32 key = 0;
+    const bool keyed = 0 == SDL_GetColorKey( surface, &key );
+    if ( keyed )
+    {
+        Uint8 r, g, b;
+        SDL_GetRGB( key, surface->format, &r, &g, &b );
+        key = Uint32(r) << 16 | Uint32(g) << 8 | b;
+    }
+
+    const Uint32 format = surface->format->format;
+    std::unique_ptr<SDL_Surface> result;
+    if ( SDL_PIXELFORMAT_RGB24 == format || SDL_PIXELFORMAT_RGBA32 == format || SDL_PIXELFORMAT_ARGB8888 == format )
+    {
+        result.reset(SDL_CreateRGBSurfaceWithFormat( 0, surface->w, surface->h, 32, SDL_PIXELFORMAT_ARGB8888 ));
+        if ( !result )
+        {
+            std::cerr << "Unable to create ARGB8888 surface! SDL_error: " << SDL_GetError() << std::endl;
+            return nullptr;
+        }
+
+        if ( SDL_MUSTLOCK(surface) && 0 != SDL_LockSurface( surface ) )
+        {
+            std::cerr << "Unable to lock surface! SDL_error: " << SDL_GetError() << std::endl;
+            return nullptr;
+        }
+        for(int y = 0; y < surface->h; y++)
+        {
+            const auto* src = static_cast<const std::uint8_t*>(surface->pixels) + y * surface->pitch;
+            auto* dst = reinterpret_cast<std::uint32_t*>(static_cast<std::uint8_t*>(result->pixels) + y * result->pitch);
+            switch (format)
+            {
+                case SDL_PIXELFORMAT_RGB24: kernels.rgb24ToArgb8888(src, dst, surface->w); break;
+                case SDL_PIXELFORMAT_RGBA32: kernels.rgba32ToArgb8888(src, dst, surface->w); break;
+                default: std::memcpy(dst, src, surface->w * 4); break;
+            }
+        }
+        if ( SDL_MUSTLOCK(surface) )
+            SDL_UnlockSurface( surface );
+    }
+    else
+    {
+        result.reset(SDL_ConvertSurfaceFormat( surface, SDL_PIXELFORMAT_ARGB8888, 0 ));
+        if ( !result )
+        {
+            std::cerr << "Unable to convert surface! SDL_error: " << SDL_GetError() << std::endl;
+            return nullptr;
+        }
+        // the key is carried over by SDL, alpha takes its place below
+        SDL_SetColorKey( result.get(), SDL_FALSE, 0 );
+    }
+
+    if ( keyed )
+    {
+        for(int y = 0; y < result->h; y++)
+            kernels.colorKeyToAlpha(reinterpret_cast<std::uint32_t*>(static_cast<std::uint8_t*>(result->pixels) + y * result->pitch), result->w, key);
+    }
+
+    SDL_SetSurfaceBlendMode( result.get(), SDL_BLENDMODE_BLEND );
+    return result;
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <SDL.h>
+
+#include "surface.hpp"
+
+// Row kernels producing SDL_PIXELFORMAT_ARGB8888, i.e. 0xAARRGGBB pixel values
+struct PixelKernels
+{
+    const char* name;
+    // source bytes R, G, B per pixel; the result is opaque
+    void (*rgb24ToArgb8888)(const std::uint8_t* src, std::uint32_t* dst, std::size_t n);
+    // source bytes R, G, B, A per pixel (SDL_PIXELFORMAT_RGBA32)
+    void (*rgba32ToArgb8888)(const std::uint8_t* src, std::uint32_t* dst, std::size_t n);
+    // pixels whose RGB equals the key's become transparent black
+    void (*colorKeyToAlpha)(std::uint32_t* pixels, std::size_t n, std::uint32_t key);
+    void (*premultiplyAlpha)(std::uint32_t* pixels, std::size_t n);
+};
+
+// Fastest kernels this CPU runs: AVX2, SSE4.1 or scalar, picked once at runtime
+const PixelKernels& pixelKernels();
+
+// Every variant this CPU runs, scalar first; for benchmarks and comparisons
+std::vector<const PixelKernels*> availablePixelKernels();
+
+// Converts to ARGB8888. Pixels matching the surface's color key, if it has one, become transparent black.
+// RGB24, RGBA32 and ARGB8888 sources go through the kernels, anything else through SDL_ConvertSurfaceFormat first.
+std::unique_ptr<SDL_Surface> convertToArgb8888(SDL_Surface* surface, const PixelKernels& kernels = pixelKernels());
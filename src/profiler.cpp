@@ -0,0 +1,195 @@
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "profiler.hpp"
+
+namespace
+{
+
+using clock = std::chrono::steady_clock;
+
+struct ThreadBuffer
+{
+    explicit ThreadBuffer(std::uint32_t id): id(id) {}
+
+    const std::uint32_t id;
+    const char* name{nullptr};  // under registryMutex
+    ProfileRing ring;
+};
+
+static_assert((profileBufferEvents & (profileBufferEvents - 1)) == 0, "the ring is indexed with a mask");
+
+// Buffers outlive their threads, so zones of finished workers still make it into the trace
+std::mutex registryMutex;
+std::vector<std::unique_ptr<ThreadBuffer>> registry;
+
+std::atomic<bool> started{false};
+// The clock pair the ticks are measured from, and scaled with against a second pair when writing
+std::uint64_t epochTicks{0};
+clock::time_point epochTime;
+
+thread_local ThreadBuffer* t_buffer = nullptr;
+// A name given before the thread recorded anything, its buffer takes it when it's created
+thread_local const char* t_name = nullptr;
+
+ThreadBuffer& threadBuffer()
+{
+    if ( !t_buffer )
+    {
+        std::lock_guard lock(registryMutex);
+        registry.push_back(std::make_unique<ThreadBuffer>(static_cast<std::uint32_t>(registry.size() + 1)));
+        t_buffer = registry.back().get();
+        t_buffer->name = t_name;
+        t_profileRing = &t_buffer->ring;
+    }
+    return *t_buffer;
+}
+
+void writeEscaped(std::ostream& os, const char* text)
+{
+    for(; *text; text++)
+    {
+        const char c = *text;
+        if ( '"' == c || '\\' == c )
+            os << '\\' << c;
+        else if ( static_cast<unsigned char>(c) < 0x20 )
+            os << ' ';
+        else
+            os << c;
+    }
+}
+
+}
+
+void startProfiling() noexcept
+{
+    // a restart keeps the first epoch, the events recorded so far stay valid
+    if ( !started.load(std::memory_order_relaxed) )
+    {
+        epochTime = clock::now();
+        epochTicks = profileTicks();
+        started.store(true, std::memory_order_release);
+    }
+    profilerRecording.store(true, std::memory_order_release);
+}
+
+void stopProfiling() noexcept
+{
+    profilerRecording.store(false, std::memory_order_release);
+}
+
+bool profiling() noexcept
+{
+    return profilerRecording.load(std::memory_order_relaxed);
+}
+
+void profileThreadName(const char* name) noexcept
+{
+    // threads that never record a zone, like idle workers, don't get a ring
+    t_name = name;
+    if ( t_buffer )
+    {
+        std::lock_guard lock(registryMutex);
+        t_buffer->name = name;
+    }
+}
+
+ProfileRing* profileRing() noexcept
+{
+    try
+    {
+        return &threadBuffer().ring;
+    }
+    catch (...)
+    {
+        return nullptr;
+    }
+}
+
+std::uint64_t profiledZones() noexcept
+{
+    std::lock_guard lock(registryMutex);
+    std::uint64_t zones = 0;
+    for(const auto& buffer : registry)
+        zones += buffer->ring.written.load(std::memory_order_acquire);
+    return zones;
+}
+
+std::uint64_t droppedZones() noexcept
+{
+    std::lock_guard lock(registryMutex);
+    std::uint64_t dropped = 0;
+    for(const auto& buffer : registry)
+    {
+        const std::uint64_t written = buffer->ring.written.load(std::memory_order_acquire);
+        if ( written > profileBufferEvents )
+            dropped += written - profileBufferEvents;
+    }
+    return dropped;
+}
+
+bool writeChromeTrace(const std::filesystem::path& path)
+{
+    if ( !started.load(std::memory_order_acquire) )
+    {
+        std::cerr << "Nothing to trace into " << path << ", profiling wasn't started" << std::endl;
+        return false;
+    }
+
+    std::ofstream out(path, std::ios::trunc);
+    if ( !out )
+    {
+        std::cerr << "Unable to create trace " << path << std::endl;
+        return false;
+    }
+
+    const std::uint64_t nowTicks = profileTicks();
+    const double elapsedUs = std::chrono::duration<double, std::micro>(clock::now() - epochTime).count();
+    const double usPerTick = nowTicks > epochTicks ? elapsedUs / double(nowTicks - epochTicks) : 0.0;
+    auto micros = [&](std::uint64_t ticks) {
+        // zones only open once the epoch is set, but the TSCs of two cores may be a few ticks apart
+        return ticks > epochTicks ? double(ticks - epochTicks) * usPerTick : 0.0;
+    };
+
+    std::lock_guard lock(registryMutex);
+    char number[64];
+    bool first = true;
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    for(const auto& buffer : registry)
+    {
+        out << (first ? "\n" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->id
+            << ",\"args\":{\"name\":\"";
+        if ( buffer->name )
+            writeEscaped(out, buffer->name);
+        else
+            out << "thread " << buffer->id;
+        out << "\"}}";
+        first = false;
+
+        const std::uint64_t written = buffer->ring.written.load(std::memory_order_acquire);
+        const std::uint64_t oldest = written > profileBufferEvents ? written - profileBufferEvents : 0;
+        for(std::uint64_t i = oldest; i < written; i++)
+        {
+            const ProfileEvent& e = buffer->ring.events[i & (profileBufferEvents - 1)];
+            out << ",\n{\"name\":\"";
+            writeEscaped(out, e.name);
+            const double duration = e.end > e.start ? double(e.end - e.start) * usPerTick : 0.0;
+            std::snprintf(number, sizeof(number), "%.3f,\"dur\":%.3f", micros(e.start), duration);
+            out << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->id << ",\"ts\":" << number << '}';
+        }
+    }
+    out << "\n]}\n";
+
+    if ( !out.flush() )
+    {
+        std::cerr << "Unable to write trace " << path << std::endl;
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <chrono>
+#endif
+
+// Scoped zones, recorded into a ring buffer per thread and written out as Chrome trace events, for
+// chrome://tracing or ui.perfetto.dev. A recorded zone costs two timestamp reads and a store into the
+// thread's own buffer, nothing is shared on the hot path. Until startProfiling() a zone only tests a flag.
+// Building with -DNO_PROFILER (make PROFILER=0) compiles every zone out.
+//
+// Zone and thread names are kept by pointer, they must be string literals.
+
+#ifndef NO_PROFILER
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+// Times the rest of the enclosing scope
+#define PROFILE_ZONE(name) ProfileZone PROFILE_CONCAT(profileZone, __LINE__)(name)
+#define PROFILE_THREAD(name) profileThreadName(name)
+#else
+#define PROFILE_ZONE(name) do {} while (false)
+#define PROFILE_THREAD(name) do {} while (false)
+#endif
+
+// Raw timestamp, the TSC on x86, converted to microseconds only when the trace is written
+inline std::uint64_t profileTicks() noexcept
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return static_cast<std::uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+}
+
+// Events kept per thread, the oldest are overwritten once a thread has recorded more
+constexpr std::size_t profileBufferEvents = 1 << 16;
+
+// Read by every zone, set through startProfiling and stopProfiling
+inline std::atomic<bool> profilerRecording{false};
+
+struct ProfileEvent
+{
+    const char* name;
+    std::uint64_t start;
+    std::uint64_t end;
+};
+
+// A thread's events, written by that thread only and read by writeChromeTrace up to the published count
+struct ProfileRing
+{
+    std::atomic<std::uint64_t> written{0};
+    std::unique_ptr<ProfileEvent[]> events{new ProfileEvent[profileBufferEvents]};
+};
+
+// Constant initialized, so zones reach it without a TLS wrapper call; set by the thread's first recorded zone
+inline thread_local ProfileRing* t_profileRing = nullptr;
+// Registers the calling thread's ring, nullptr if it can't be allocated
+ProfileRing* profileRing() noexcept;
+
+void startProfiling() noexcept;
+void stopProfiling() noexcept;
+bool profiling() noexcept;
+
+// Names the calling thread in the trace, its buffer is only allocated by its first recorded zone
+void profileThreadName(const char* name) noexcept;
+
+inline void recordZone(const char* name, std::uint64_t start, std::uint64_t end) noexcept
+{
+    if ( !profilerRecording.load(std::memory_order_relaxed) )
+        return;
+    ProfileRing* ring = t_profileRing;
+    if ( !ring && !(ring = profileRing()) )
+        return;
+
+    const std::uint64_t n = ring->written.load(std::memory_order_relaxed);
+    ring->events[n & (profileBufferEvents - 1)] = ProfileEvent{name, start, end};
+    ring->written.store(n + 1, std::memory_order_release);
+}
+
+// Every thread's events as complete ("X") events, sorted by thread. Threads may keep recording while
+// this runs, but a thread wrapping its ring meanwhile tears its oldest events, so call it when they're idle.
+bool writeChromeTrace(const std::filesystem::path& path);
+// Zones recorded by every thread so far, and those of them overwritten by wrapping rings
+std::uint64_t profiledZones() noexcept;
+std::uint64_t droppedZones() noexcept;
+
+class ProfileZone
+{
+public:
+    explicit ProfileZone(const char* name) noexcept:
+        m_name(name), m_start(profilerRecording.load(std::memory_order_acquire) ? profileTicks() : 0)
+    {
+    }
+    // zones opened before recording started are left out
+    ~ProfileZone()
+    {
+        if ( m_start )
+            recordZone(m_name, m_start, profileTicks());
+    }
+
+    ProfileZone(const ProfileZone&) = delete;
+    ProfileZone& operator=(const ProfileZone&) = delete;
+
+private:
+    const char* m_name;
+    std::uint64_t m_start;
+};
@@ -0,0 +1,195 @@
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+#include "quadtree.hpp"
+
+void LooseQuadtree::reset(float width, float height)
+{
+    m_width = width;
+    m_height = height;
+    m_size = std::max({width, height, 1.0f});
+
+    m_nodes.assign(levelOffset(m_depth + 1), {});
+    m_x.clear();
+    m_y.clear();
+    m_r.clear();
+    m_node.clear();
+    m_slot.clear();
+}
+
+std::uint32_t LooseQuadtree::levelOffset(int level) const noexcept
+{
+    // 1 + 4 + 16 + ... + 4^(level-1)
+    return ((1u << (2 * level)) - 1) / 3;
+}
+
+float LooseQuadtree::cellSize(int level) const noexcept
+{
+    return m_size / static_cast<float>(1u << level);
+}
+
+int LooseQuadtree::levelFor(float r) const noexcept
+{
+    if ( r <= 0 )
+        return m_depth;
+    const int level = static_cast<int>(std::floor(std::log2(m_size / (2 * r))));
+    return std::clamp(level, 0, m_depth);
+}
+
+std::uint32_t LooseQuadtree::nodeFor(float x, float y, float r) const noexcept
+{
+    const int level = levelFor(r);
+    const int cells = 1 << level;
+    const float inv = cells / m_size;
+    const int cx = std::clamp(static_cast<int>(x * inv), 0, cells - 1);
+    const int cy = std::clamp(static_cast<int>(y * inv), 0, cells - 1);
+    return levelOffset(level) + cy * cells + cx;
+}
+
+void LooseQuadtree::link(std::uint32_t id, std::uint32_t node)
+{
+    m_node[id] = node;
+    m_slot[id] = static_cast<std::uint32_t>(m_nodes[node].size());
+    m_nodes[node].push_back(id);
+}
+
+void LooseQuadtree::unlink(std::uint32_t id)
+{
+    // swap with the last object of the node so removal is O(1)
+    std::vector<std::uint32_t>& items = m_nodes[m_node[id]];
+    const std::uint32_t last = items.back();
+    items[m_slot[id]] = last;
+    m_slot[last] = m_slot[id];
+    items.pop_back();
+    m_node[id] = noNode;
+}
+
+void LooseQuadtree::insert(std::uint32_t id, float x, float y, float r)
+{
+    assert( !m_nodes.empty() );
+    if ( id >= m_node.size() )
+    {
+        m_x.resize(id + 1);
+        m_y.resize(id + 1);
+        m_r.resize(id + 1);
+        m_node.resize(id + 1, noNode);
+        m_slot.resize(id + 1);
+    }
+    if ( noNode != m_node[id] )
+        unlink(id);
+
+    m_x[id] = x;
+    m_y[id] = y;
+    m_r[id] = r;
+    link(id, nodeFor(x, y, r));
+}
+
+void LooseQuadtree::update(std::uint32_t id, float x, float y, float r)
+{
+    assert( id < m_node.size() );
+    m_x[id] = x;
+    m_y[id] = y;
+    m_r[id] = r;
+
+    const std::uint32_t node = nodeFor(x, y, r);
+    if ( node != m_node[id] )
+    {
+        unlink(id);
+        link(id, node);
+    }
+}
+
+void LooseQuadtree::updateAll(const float* x, const float* y, const float* r, std::size_t n, float width, float height)
+{
+    if ( m_nodes.empty() || width != m_width || height != m_height || n != m_node.size() )
+    {
+        reset(width, height);
+        for(std::size_t i = 0; i < n; i++)
+            insert(static_cast<std::uint32_t>(i), x[i], y[i], r[i]);
+        return;
+    }
+
+    for(std::size_t i = 0; i < n; i++)
+        update(static_cast<std::uint32_t>(i), x[i], y[i], r[i]);
+}
+
+template<typename F>
+void LooseQuadtree::forCells(int level, float x0, float y0, float x1, float y1, F&& f) const
+{
+    const int cells = 1 << level;
+    const float inv = cells / m_size;
+    const int cx0 = std::clamp(static_cast<int>(std::floor(x0 * inv)), 0, cells - 1);
+    const int cy0 = std::clamp(static_cast<int>(std::floor(y0 * inv)), 0, cells - 1);
+    const int cx1 = std::clamp(static_cast<int>(std::floor(x1 * inv)), 0, cells - 1);
+    const int cy1 = std::clamp(static_cast<int>(std::floor(y1 * inv)), 0, cells - 1);
+
+    const std::uint32_t offset = levelOffset(level);
+    for(int cy = cy0; cy <= cy1; cy++)
+        for(int cx = cx0; cx <= cx1; cx++)
+            for(std::uint32_t id : m_nodes[offset + cy * cells + cx])
+                f(id);
+}
+
+void LooseQuadtree::queryPoint(float x, float y, std::vector<std::uint32_t>& out) const
+{
+    queryRect(x, y, x, y, out);
+}
+
+void LooseQuadtree::queryRect(float x0, float y0, float x1, float y1, std::vector<std::uint32_t>& out) const
+{
+    out.clear();
+    if ( m_nodes.empty() )
+        return;
+
+    for(int level = 0; level <= m_depth; level++)
+    {
+        // a loose cell reaches half a cell further than its own bounds
+        const float margin = cellSize(level) / 2;
+        forCells(level, x0 - margin, y0 - margin, x1 + margin, y1 + margin, [&](std::uint32_t id)
+        {
+            const float cx = std::clamp(m_x[id], x0, x1);
+            const float cy = std::clamp(m_y[id], y0, y1);
+            const float dx = m_x[id] - cx;
+            const float dy = m_y[id] - cy;
+            if ( dx*dx + dy*dy <= m_r[id] * m_r[id] )
+                out.push_back(id);
+        });
+    }
+}
+
+void LooseQuadtree::queryNearest(float x, float y, std::size_t k, std::vector<std::uint32_t>& out) const
+{
+    out.clear();
+    if ( m_nodes.empty() || 0 == k || m_node.empty() )
+        return;
+
+    k = std::min(k, m_node.size());
+
+    // Grow a search box until it holds k centres within its inscribed circle;
+    // centres always lie inside their own (tight) cell, so no loose margin is needed
+    std::vector<std::pair<float, std::uint32_t>> found;
+    for(float radius = cellSize(m_depth); ; radius *= 2)
+    {
+        found.clear();
+        const float r2 = radius * radius;
+        for(int level = 0; level <= m_depth; level++)
+            forCells(level, x - radius, y - radius, x + radius, y + radius, [&](std::uint32_t id)
+            {
+                const float dx = m_x[id] - x;
+                const float dy = m_y[id] - y;
+                const float d2 = dx*dx + dy*dy;
+                if ( d2 <= r2 )
+                    found.emplace_back(d2, id);
+            });
+
+        const bool coversWorld = radius >= 2 * m_size;
+        if ( found.size() >= k || coversWorld )
+            break;
+    }
+
+    k = std::min(k, found.size());
+    std::partial_sort(found.begin(), found.begin() + k, found.end());
+    for(std::size_t i = 0; i < k; i++)
+        out.push_back(found[i].second);
+}
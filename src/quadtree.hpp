@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Loose quadtree of circles with all levels preallocated.
+// A circle lives in the deepest cell whose size is at least its diameter and
+// that contains its centre; cells are "loose", i.e. their bounds are grown by
+// half a cell on every side, so the circle always fits. Finding the node for a
+// circle is O(1), which makes moving objects cheap: update() only touches the
+// tree when a circle leaves its cell or changes level.
+class LooseQuadtree
+{
+public:
+    explicit LooseQuadtree(int depth = 8): m_depth(depth) {}
+
+    // Drops everything and covers [0, width] x [0, height]
+    void reset(float width, float height);
+
+    float width() const noexcept {return m_width;}
+    float height() const noexcept {return m_height;}
+    std::size_t size() const noexcept {return m_node.size();}
+
+    // Ids are dense: inserting id n grows the tree to n + 1 objects
+    void insert(std::uint32_t id, float x, float y, float r);
+    void update(std::uint32_t id, float x, float y, float r);
+
+    // Updates objects [0, n) from SoA arrays, rebuilding when the bounds or count changed
+    void updateAll(const float* x, const float* y, const float* r, std::size_t n, float width, float height);
+
+    // Objects whose circle contains (x, y)
+    void queryPoint(float x, float y, std::vector<std::uint32_t>& out) const;
+    // Objects whose circle overlaps the rectangle [x0, x1] x [y0, y1]
+    void queryRect(float x0, float y0, float x1, float y1, std::vector<std::uint32_t>& out) const;
+    // Up to k objects with the closest centres, nearest first
+    void queryNearest(float x, float y, std::size_t k, std::vector<std::uint32_t>& out) const;
+
+private:
+    static constexpr std::uint32_t noNode = UINT32_MAX;
+
+    int levelFor(float r) const noexcept;
+    std::uint32_t nodeFor(float x, float y, float r) const noexcept;
+    std::uint32_t levelOffset(int level) const noexcept;
+    float cellSize(int level) const noexcept;
+
+    void link(std::uint32_t id, std::uint32_t node);
+    void unlink(std::uint32_t id);
+
+    template<typename F>
+    void forCells(int level, float x0, float y0, float x1, float y1, F&& f) const;
+
+    int m_depth{8};
+    float m_width{0};
+    float m_height{0};
+    float m_size{0};
+
+    std::vector<std::vector<std::uint32_t>> m_nodes;
+
+    // per object
+    std::vector<float> m_x;
+    std::vector<float> m_y;
+    std::vector<float> m_r;
+    std::vector<std::uint32_t> m_node;
+    std::vector<std::uint32_t> m_slot;
+};
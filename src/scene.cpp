@@ -1,62 +1,239 @@
 #include "scene.hpp"
+#include "profiler.hpp"
+#include <algorithm>
+#include <cmath>
 #include <random>
 
-Scene::Scene()
+namespace
+{
+  // balls per job: big enough to amortize scheduling, small enough to balance cores
+  const std::size_t ballGrain = 16384;
+}
+
+std::uint32_t Scene::randomSeed()
 {
   std::random_device dev;
-  std::mt19937 rng(dev());
-  std::uniform_int_distribution<std::mt19937::result_type> rndX(0, 1280);
-  std::uniform_int_distribution<std::mt19937::result_type> rndY(0, 960);
+  return dev();
+}
+
+Scene::Scene(std::size_t ballCount, JobSystem* jobs, std::uint32_t seed, float worldWidth, float worldHeight):
+  m_jobs(jobs), m_seed(seed), m_worldWidth(worldWidth), m_worldHeight(worldHeight)
+{
+  std::mt19937 rng(seed);
+  std::uniform_int_distribution<std::mt19937::result_type> rndX(0, worldWidth);
+  std::uniform_int_distribution<std::mt19937::result_type> rndY(0, worldHeight);
   std::uniform_int_distribution<std::mt19937::result_type> rndVX(100, 500);
   std::uniform_int_distribution<std::mt19937::result_type> rndVY(100, 500);
   std::uniform_int_distribution<std::mt19937::result_type> rndR(5,50);
   std::uniform_int_distribution<std::mt19937::result_type> rndSign(0,1);
 
-  for(size_t i = 0; i < 10; i++)
+  m_balls.reserve(ballCount);
+  for(size_t i = 0; i < ballCount; i++)
   {
      const int signX = 1 - rndSign(rng)*2;
      const int signY = 1 - rndSign(rng)*2;
      const vec2 rndVelocity (static_cast<int>(rndVX(rng))*signX, static_cast<int>(rndVY(rng))*signY);
-     m_balls.emplace_back(vec2(rndX(rng), rndY(rng)), rndR(rng), rndVelocity);
+     m_balls.push_back(Ball(vec2(rndX(rng), rndY(rng)), rndR(rng), rndVelocity));
    }
+
+  m_grid.setCellSize(2.0f * rndR.max());
 }
 
-void Scene::update(const Context& ctx, const std::chrono::steady_clock::duration& dt)
+Scene::Scene(ParticleStore&& balls, float worldWidth, float worldHeight, JobSystem* jobs, std::uint32_t seed):
+  m_jobs(jobs), m_seed(seed), m_worldWidth(worldWidth), m_worldHeight(worldHeight), m_balls(std::move(balls))
 {
-  const float dtMilliseconds =  std::chrono::duration_cast<std::chrono::milliseconds>(dt).count() / 1000.0;
+  const float* r = m_balls.r();
+  const float maxR = m_balls.empty() ? 1.0f : *std::max_element(r, r + m_balls.size());
+  m_grid.setCellSize(2.0f * std::max(maxR, 1.0f));
+}
 
-  for(Ball&b : m_balls)
+void Scene::update(const std::chrono::steady_clock::duration& dt)
+{
+  PROFILE_ZONE("Scene::update");
+  const float dtSeconds = std::chrono::duration<float>(dt).count();
+
+  // previous positions only exist once the scene has been stepped
+  m_prevX.resize(m_balls.size());
+  m_prevY.resize(m_balls.size());
+
+  const float width = m_worldWidth;
+  const float height = m_worldHeight;
+
+  auto integrate = [&](std::size_t begin, std::size_t end)
   {
-      b.p() += b.v() * dtMilliseconds;
+    std::copy(m_balls.x() + begin, m_balls.x() + end, m_prevX.data() + begin);
+    std::copy(m_balls.y() + begin, m_balls.y() + end, m_prevY.data() + begin);
+    integrateAndReflect(m_balls, begin, end, dtSeconds, width, height);
+  };
 
-      if ( b.p().x() > ctx.width() )
-      {
-        b.p().x() = ctx.width();
-        b.v().x() = - b.v().x();
-      }
+  if ( m_jobs )
+    m_jobs->parallelFor(0, m_balls.size(), ballGrain, integrate);
+  else
+    integrate(0, m_balls.size());
 
-      if ( b.p().x() < 0 )
-      {
-        b.p().x() = 0;
-        b.v().x() = - b.v().x();
-      }
+  if ( m_collisions )
+    resolveCollisions();
 
-      if ( b.p().y() > ctx.height() )
-      {
-        b.p().y() = ctx.height();
-        b.v().y() = - b.v().y();
-      }
+  m_indexStale = true;
+}
+
+void Scene::refreshIndex() const
+{
+  if ( !m_indexStale )
+    return;
+  m_index.updateAll(m_balls.x(), m_balls.y(), m_balls.r(), m_balls.size(), m_worldWidth, m_worldHeight);
+  m_indexStale = false;
+}
 
-      if (  b.p().y() < 0 )
+void Scene::setBall(std::size_t i, const Ball& b)
+{
+  m_balls.setBall(i, b);
+  // the ball is where it was put, not on its way there from where the last step left it
+  if ( i < m_prevX.size() )
+  {
+    m_prevX[i] = b.p().x();
+    m_prevY[i] = b.p().y();
+  }
+  // a stale tree picks the ball up with everything else on the next query
+  if ( !m_indexStale && i < m_index.size() )
+    m_index.update(static_cast<std::uint32_t>(i), b.p().x(), b.p().y(), b.r());
+}
+
+void Scene::ballsAt(float x, float y, std::vector<std::uint32_t>& out) const
+{
+  refreshIndex();
+  m_index.queryPoint(x, y, out);
+}
+
+void Scene::ballsIn(const SDL_FRect& rect, std::vector<std::uint32_t>& out) const
+{
+  refreshIndex();
+  m_index.queryRect(rect.x, rect.y, rect.x + rect.w, rect.y + rect.h, out);
+}
+
+void Scene::nearestBalls(float x, float y, std::size_t k, std::vector<std::uint32_t>& out) const
+{
+  refreshIndex();
+  m_index.queryNearest(x, y, k, out);
+}
+
+void Scene::resolveCollisions()
+{
+  float* x = m_balls.x();
+  float* y = m_balls.y();
+  float* vx = m_balls.vx();
+  float* vy = m_balls.vy();
+  const float* r = m_balls.r();
+
+  auto collide = [&](std::uint32_t i, std::uint32_t j)
+  {
+      const float dx = x[j] - x[i];
+      const float dy = y[j] - y[i];
+      const float rr = r[i] + r[j];
+      const float d2 = dx*dx + dy*dy;
+      if ( d2 >= rr*rr || d2 == 0 )
+        return false;
+
+      // mass is proportional to the area of the ball
+      const float mi = r[i] * r[i];
+      const float mj = r[j] * r[j];
+      const float invM = 1.0f / (mi + mj);
+
+      const float d = std::sqrt(d2);
+      const float nx = dx / d;
+      const float ny = dy / d;
+
+      // push the balls apart so they don't stick together on the next step
+      const float overlap = rr - d;
+      x[i] -= nx * overlap * mj * invM;
+      y[i] -= ny * overlap * mj * invM;
+      x[j] += nx * overlap * mi * invM;
+      y[j] += ny * overlap * mi * invM;
+
+      // separation must not push anything through the walls
+      x[i] = std::clamp(x[i], 0.0f, m_worldWidth);
+      y[i] = std::clamp(y[i], 0.0f, m_worldHeight);
+      x[j] = std::clamp(x[j], 0.0f, m_worldWidth);
+      y[j] = std::clamp(y[j], 0.0f, m_worldHeight);
+
+      const float vn = (vx[j] - vx[i]) * nx + (vy[j] - vy[i]) * ny;
+      if ( vn < 0 )
       {
-        b.p().y() = 0;
-        b.v().y() = - b.v().y();
+        const float impulse = 2.0f * vn * invM;
+        vx[i] += impulse * mj * nx;
+        vy[i] += impulse * mj * ny;
+        vx[j] -= impulse * mi * nx;
+        vy[j] -= impulse * mi * ny;
       }
-  }
+      return true;
+  };
+
+  m_grid.build(x, y, m_balls.size(), m_worldWidth, m_worldHeight);
+  if ( m_jobs )
+    m_grid.forEachPairParallel(*m_jobs, collide);
+  else
+    m_grid.forEachPair(collide);
 }
 
-void Scene::render(Context& ctx)
+void Scene::render(Context& ctx, const Camera& camera, float alpha)
 {
-  for(Ball& b: m_balls)
-    b.render(ctx);
-}
\ No newline at end of file
+  PROFILE_ZONE("Scene::render");
+  const float* x = m_balls.x();
+  const float* y = m_balls.y();
+  const float* r = m_balls.r();
+
+  // nothing to interpolate from before the first update
+  const bool interpolate = m_prevX.size() == m_balls.size();
+  const float* prevX = interpolate ? m_prevX.data() : x;
+  const float* prevY = interpolate ? m_prevY.data() : y;
+
+  const SDL_FRect view = camera.visibleWorld();
+  const float left = view.x;
+  const float top = view.y;
+  const float right = view.x + view.w;
+  const float bottom = view.y + view.h;
+  const float zoom = camera.zoom();
+
+  // every chunk packs its visible balls to the front of its own range of m_rects
+  m_rects.resize(m_balls.size());
+  m_chunkVisible.assign((m_balls.size() + ballGrain - 1) / ballGrain, 0);
+  auto build = [&](std::size_t begin, std::size_t end)
+  {
+    std::size_t out = begin;
+    for(std::size_t i = begin; i < end; i++)
+    {
+      const float px = prevX[i] + (x[i] - prevX[i]) * alpha;
+      const float py = prevY[i] + (y[i] - prevY[i]) * alpha;
+      if ( px + r[i] < left || px - r[i] > right || py + r[i] < top || py - r[i] > bottom )
+        continue;
+      m_rects[out++] = SDL_FRect{ (px - r[i] - left) * zoom, (py - r[i] - top) * zoom, 2 * r[i] * zoom, 2 * r[i] * zoom };
+    }
+    m_chunkVisible[begin / ballGrain] = out - begin;
+  };
+
+  if ( m_jobs )
+    m_jobs->parallelFor(0, m_balls.size(), ballGrain, build);
+  else
+    for(std::size_t begin = 0; begin < m_balls.size(); begin += ballGrain)
+      build(begin, std::min(begin + ballGrain, m_balls.size()));
+
+  m_visible = 0;
+  for(std::size_t c = 0; c < m_chunkVisible.size(); c++)
+  {
+    // the chunks only ever move down, and stay put while every chunk before them is fully visible;
+    // std::copy can't be given a destination inside its source
+    const auto chunk = m_rects.begin() + c * ballGrain;
+    const auto destination = m_rects.begin() + m_visible;
+    if ( destination != chunk )
+      std::copy(chunk, chunk + m_chunkVisible[c], destination);
+    m_visible += m_chunkVisible[c];
+  }
+
+  m_drawCalls = 0;
+  if ( 0 == m_visible )
+    return;
+
+  SDL_SetRenderDrawColor( ctx.renderer(), 0xFF, 0x00, 0x00, 0xFF );
+  SDL_RenderFillRectsF( ctx.renderer(), m_rects.data(), static_cast<int>(m_visible) );
+  m_drawCalls++;
+}
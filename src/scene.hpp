@@ -1,19 +1,91 @@
 #pragma once
 
 #include <chrono>
+#include <cstddef>
+#include <cstdint>
 #include <vector>
 #include "ball.hpp"
+#include "camera.hpp"
 #include "context.hpp"
+#include "job_system.hpp"
+#include "particles.hpp"
+#include "spatial_grid.hpp"
+#include "quadtree.hpp"
 
 class Scene
 {
 public:
-  Scene();
+  static constexpr float defaultWorldWidth = 1280;
+  static constexpr float defaultWorldHeight = 960;
 
-  void update(const Context&, const std::chrono::steady_clock::duration&);
+  // Balls are spread over a world of [0, worldWidth] x [0, worldHeight] and bounce off its walls.
+  // Without a job system everything is simulated on the calling thread.
+  // The same seed, ball count and world size always give the same initial scene.
+  explicit Scene(std::size_t ballCount = 10, JobSystem* jobs = nullptr, std::uint32_t seed = randomSeed(),
+    float worldWidth = defaultWorldWidth, float worldHeight = defaultWorldHeight);
 
-  void render(Context&);
+  // Takes over existing ball state, e.g. a snapshot; borrowed arrays are used in place
+  Scene(ParticleStore&& balls, float worldWidth, float worldHeight, JobSystem* jobs = nullptr, std::uint32_t seed = 0);
+
+  static std::uint32_t randomSeed();
+  std::uint32_t seed() const noexcept {return m_seed;}
+
+  float worldWidth() const noexcept {return m_worldWidth;}
+  float worldHeight() const noexcept {return m_worldHeight;}
+
+  void update(const std::chrono::steady_clock::duration&);
+
+  // alpha blends between the state before and after the last update, see FixedTimestep.
+  // Balls outside the camera view are culled, the rest go to the renderer in a single batch.
+  void render(Context&, const Camera&, float alpha = 1.0f);
+
+  // Number of SDL draw submissions made by the last render()
+  std::size_t drawCalls() const noexcept {return m_drawCalls;}
+  // Balls drawn and skipped by the last render()
+  std::size_t visibleCount() const noexcept {return m_visible;}
+  std::size_t culledCount() const noexcept {return m_balls.size() - m_visible;}
+
+  std::size_t size() const noexcept {return m_balls.size();}
+
+  const ParticleStore& balls() const noexcept {return m_balls;}
+
+  Ball ball(std::size_t i) const {return m_balls.ball(i);}
+  void setBall(std::size_t i, const Ball& b);
+
+  // Spatial queries, answered from a loose quadtree of the balls as of the last update (or setBall).
+  // update() only marks the tree stale, the first query after it brings the tree up to date.
+  void ballsAt(float x, float y, std::vector<std::uint32_t>& out) const;
+  void ballsIn(const SDL_FRect& rect, std::vector<std::uint32_t>& out) const;
+  void nearestBalls(float x, float y, std::size_t k, std::vector<std::uint32_t>& out) const;
+
+  // Ball-ball collisions are on by default; with many large balls on a small field they dominate update()
+  void setCollisions(bool enabled) noexcept {m_collisions = enabled;}
+  bool collisions() const noexcept {return m_collisions;}
+
+  // Broadphase used for ball-ball collisions; cell size defaults to the largest ball diameter
+  SpatialGrid& grid() noexcept {return m_grid;}
+  const SpatialGrid& grid() const noexcept {return m_grid;}
 
 private:
-  std::vector<Ball> m_balls;
-};
\ No newline at end of file
+  void resolveCollisions();
+  // Brings m_index up to date if an update moved the balls since
+  void refreshIndex() const;
+
+  JobSystem* m_jobs{nullptr};
+  std::uint32_t m_seed{0};
+  float m_worldWidth{defaultWorldWidth};
+  float m_worldHeight{defaultWorldHeight};
+  ParticleStore m_balls;
+  FloatArray m_prevX;
+  FloatArray m_prevY;
+
+  std::vector<SDL_FRect> m_rects;
+  std::vector<std::size_t> m_chunkVisible;
+  std::size_t m_drawCalls{0};
+  std::size_t m_visible{0};
+  SpatialGrid m_grid{1};
+  // only queries need it, so it is refreshed on demand rather than on every step
+  mutable LooseQuadtree m_index;
+  mutable bool m_indexStale{true};
+  bool m_collisions{true};
+};
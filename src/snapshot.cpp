@@ -0,0 +1,142 @@
+#include <iostream>
+#include <fstream>
+#include <cstring>
+#include <memory>
+
+#include "mapped_file.hpp"
+#include "snapshot.hpp"
+
+namespace
+{
+
+const char snapshotMagic[8] = {'S', 'D', 'L', 'S', 'N', 'A', 'P', 0};
+// version 2 appended the world size, version 1 files get the default world
+const std::uint32_t snapshotVersion = 2;
+const std::uint32_t snapshotV1HeaderSize = 72;
+const std::uint64_t snapshotAlignment = 64;
+
+struct SnapshotHeader
+{
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t headerSize;
+    std::uint64_t count;
+    std::uint32_t seed;
+    std::uint32_t reserved;
+    std::uint64_t offsets[ParticleStore::ComponentCount];
+    float worldWidth;
+    float worldHeight;
+};
+
+std::uint64_t alignUp(std::uint64_t v)
+{
+    return (v + snapshotAlignment - 1) / snapshotAlignment * snapshotAlignment;
+}
+
+}
+
+bool saveSnapshot(const std::filesystem::path& path, const ParticleStore& balls, std::uint32_t seed,
+    float worldWidth, float worldHeight)
+{
+    SnapshotHeader header{};
+    std::memcpy(header.magic, snapshotMagic, sizeof(snapshotMagic));
+    header.version = snapshotVersion;
+    header.headerSize = sizeof(SnapshotHeader);
+    header.count = balls.size();
+    header.seed = seed;
+    header.worldWidth = worldWidth;
+    header.worldHeight = worldHeight;
+
+    const std::uint64_t arrayBytes = balls.size() * sizeof(float);
+    std::uint64_t offset = alignUp(sizeof(SnapshotHeader));
+    for(std::uint64_t& o : header.offsets)
+    {
+        o = offset;
+        offset = alignUp(offset + arrayBytes);
+    }
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if ( !out )
+    {
+        std::cerr << "Unable to create snapshot " << path << std::endl;
+        return false;
+    }
+
+    const char padding[snapshotAlignment] = {};
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    std::uint64_t written = sizeof(header);
+    for(int c = 0; c < ParticleStore::ComponentCount; c++)
+    {
+        out.write(padding, header.offsets[c] - written);
+        out.write(reinterpret_cast<const char*>(balls.component(static_cast<ParticleStore::Component>(c))), arrayBytes);
+        written = header.offsets[c] + arrayBytes;
+    }
+
+    if ( !out.flush() )
+    {
+        std::cerr << "Unable to write snapshot " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+std::optional<Scene> loadSnapshot(const std::filesystem::path& path, JobSystem* jobs)
+{
+    auto mappingOpt = mapFile(path);
+    if ( !mappingOpt )
+        return std::nullopt;
+    auto mapping = std::make_shared<MappedFile>(std::move(mappingOpt).value());
+
+    SnapshotHeader header{};
+    if ( mapping->size() < snapshotV1HeaderSize )
+    {
+        std::cerr << "Snapshot " << path << " is too short" << std::endl;
+        return std::nullopt;
+    }
+    std::memcpy(&header, mapping->data(), snapshotV1HeaderSize);
+
+    if ( 0 != std::memcmp(header.magic, snapshotMagic, sizeof(snapshotMagic)) )
+    {
+        std::cerr << path << " is not a scene snapshot" << std::endl;
+        return std::nullopt;
+    }
+
+    if ( 1 == header.version && snapshotV1HeaderSize == header.headerSize )
+    {
+        header.worldWidth = Scene::defaultWorldWidth;
+        header.worldHeight = Scene::defaultWorldHeight;
+    }
+    else if ( snapshotVersion == header.version && sizeof(SnapshotHeader) == header.headerSize
+        && mapping->size() >= sizeof(SnapshotHeader) )
+    {
+        std::memcpy(&header, mapping->data(), sizeof(header));
+    }
+    else
+    {
+        std::cerr << "Unsupported snapshot version " << header.version << " in " << path << std::endl;
+        return std::nullopt;
+    }
+
+    // a crafted count would wrap the array size below and pass the bounds checks
+    if ( header.count > mapping->size() / sizeof(float) || header.count > FloatArray().max_size() )
+    {
+        std::cerr << "Snapshot " << path << " is truncated or corrupt" << std::endl;
+        return std::nullopt;
+    }
+
+    const std::uint64_t arrayBytes = header.count * sizeof(float);
+    ParticleStore::Arrays arrays;
+    for(int c = 0; c < ParticleStore::ComponentCount; c++)
+    {
+        const std::uint64_t offset = header.offsets[c];
+        if ( offset % snapshotAlignment != 0 || offset > mapping->size() || mapping->size() - offset < arrayBytes )
+        {
+            std::cerr << "Snapshot " << path << " is truncated or corrupt" << std::endl;
+            return std::nullopt;
+        }
+        arrays[c] = reinterpret_cast<float*>(mapping->data() + offset);
+    }
+
+    return Scene(ParticleStore::borrow(mapping, arrays, static_cast<std::size_t>(header.count)),
+        header.worldWidth, header.worldHeight, jobs, header.seed);
+}
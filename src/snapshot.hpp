@@ -0,0 +1,25 @@
+#pragma once
+
+#include <filesystem>
+#include <optional>
+
+#include "job_system.hpp"
+#include "particles.hpp"
+#include "scene.hpp"
+
+// Versioned binary image of the ball state:
+//   header (incl. world size) | x[] | y[] | vx[] | vy[] | r[]
+// every array starts on a 64 byte boundary, so a mapped file can be used as is.
+// Values are in host byte order.
+
+bool saveSnapshot(const std::filesystem::path& path, const ParticleStore& balls, std::uint32_t seed,
+    float worldWidth, float worldHeight);
+
+inline bool saveSnapshot(const std::filesystem::path& path, const Scene& scene)
+{
+    return saveSnapshot(path, scene.balls(), scene.seed(), scene.worldWidth(), scene.worldHeight());
+}
+
+// Maps the file and builds the scene on top of it: no parsing and no per-ball allocation.
+// The mapping is copy-on-write, simulating the scene never modifies the file.
+std::optional<Scene> loadSnapshot(const std::filesystem::path& path, JobSystem* jobs = nullptr);
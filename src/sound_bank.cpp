@@ -0,0 +1,263 @@
+#include <iostream>
+#include <fstream>
+#include <chrono>
+#include <cstring>
+
+#include "sound_bank.hpp"
+#include "music.hpp"
+
+namespace
+{
+
+using clock = std::chrono::steady_clock;
+
+const char bankMagic[8] = {'S', 'D', 'L', 'B', 'A', 'N', 'K', 0};
+const std::uint32_t bankVersion = 1;
+
+struct BankHeader
+{
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t headerSize;
+    std::uint32_t soundCount;
+    std::uint32_t entrySize;
+    std::uint32_t frequency;
+    std::uint16_t format;
+    std::uint16_t channels;
+    std::uint32_t namesSize;
+    std::uint32_t reserved;
+    std::uint64_t arenaOffset;
+    std::uint64_t arenaSize;
+};
+
+struct BankEntry
+{
+    std::uint64_t offset;
+    std::uint64_t size;
+    std::uint32_t nameOffset;  // into the names following the entry table
+    std::uint32_t nameSize;
+};
+
+std::uint64_t alignUp(std::uint64_t v)
+{
+    return (v + SoundBank::alignment - 1) / SoundBank::alignment * SoundBank::alignment;
+}
+
+std::string soundName(const std::filesystem::path& path)
+{
+    return path.lexically_normal().generic_string();
+}
+
+SoundBank::Arena allocateArena(std::size_t bytes)
+{
+    return SoundBank::Arena(static_cast<std::uint8_t*>(::operator new[](bytes, std::align_val_t(SoundBank::alignment))));
+}
+
+double millisecondsSince(clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(clock::now() - start).count();
+}
+
+}
+
+SoundBank::SoundBank(Format format, Arena&& arena, std::size_t arenaBytes, std::map<std::string, Sound>&& sounds,
+    double loadMs):
+    m_format(format), m_arena(std::move(arena)), m_arenaBytes(arenaBytes), m_sounds(std::move(sounds)), m_loadMs(loadMs)
+{
+}
+
+bool SoundBank::contains(const std::filesystem::path& name) const
+{
+    return m_sounds.count(soundName(name)) > 0;
+}
+
+std::size_t SoundBank::bytes(const std::filesystem::path& name) const
+{
+    auto it = m_sounds.find(soundName(name));
+    return it == m_sounds.end() ? 0 : it->second.size;
+}
+
+ChunkHandle SoundBank::chunk(const std::filesystem::path& name)
+{
+    auto it = m_sounds.find(soundName(name));
+    if ( it == m_sounds.end() )
+        return nullptr;
+
+    Mix_Chunk* chunk = Mix_QuickLoad_RAW( m_arena.get() + it->second.offset, static_cast<Uint32>(it->second.size) );
+    if ( NULL == chunk )
+    {
+        std::cerr << "Failed to load chunk " << name << " from sound bank! SDL_mixer Error: " << Mix_GetError() << std::endl;
+        return nullptr;
+    }
+
+    // a quick loaded chunk plays the arena in place and doesn't own it
+    return ChunkHandle(chunk, [bank = shared_from_this()](Mix_Chunk* c) { Mix_FreeChunk( c ); });
+}
+
+bool SoundBank::save(const std::filesystem::path& path) const
+{
+    std::vector<BankEntry> entries;
+    std::string names;
+    for(const auto& [name, sound] : m_sounds)
+    {
+        entries.push_back({sound.offset, sound.size, static_cast<std::uint32_t>(names.size()),
+            static_cast<std::uint32_t>(name.size())});
+        names += name;
+    }
+
+    BankHeader header{};
+    std::memcpy(header.magic, bankMagic, sizeof(bankMagic));
+    header.version = bankVersion;
+    header.headerSize = sizeof(BankHeader);
+    header.soundCount = static_cast<std::uint32_t>(entries.size());
+    header.entrySize = sizeof(BankEntry);
+    header.frequency = static_cast<std::uint32_t>(m_format.frequency);
+    header.format = m_format.format;
+    header.channels = static_cast<std::uint16_t>(m_format.channels);
+    header.namesSize = static_cast<std::uint32_t>(names.size());
+    const std::uint64_t tableEnd = sizeof(BankHeader) + entries.size() * sizeof(BankEntry) + names.size();
+    header.arenaOffset = alignUp(tableEnd);
+    header.arenaSize = m_arenaBytes;
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if ( !out )
+    {
+        std::cerr << "Unable to create sound bank " << path << std::endl;
+        return false;
+    }
+
+    const char padding[alignment] = {};
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(BankEntry));
+    out.write(names.data(), names.size());
+    out.write(padding, header.arenaOffset - tableEnd);
+    out.write(reinterpret_cast<const char*>(m_arena.get()), m_arenaBytes);
+    if ( !out.flush() )
+    {
+        std::cerr << "Unable to write sound bank " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+SoundBank::Format deviceSoundFormat()
+{
+    SoundBank::Format format{mixerFrequency, mixerFormat, mixerChannels};
+    int frequency = 0;
+    Uint16 deviceFormat = 0;
+    int channels = 0;
+    if ( Mix_QuerySpec( &frequency, &deviceFormat, &channels ) )
+        format = {frequency, deviceFormat, channels};
+    return format;
+}
+
+std::shared_ptr<SoundBank> loadSoundBank(const std::vector<std::filesystem::path>& paths, JobSystem* jobs,
+    const SoundBank::Format& format)
+{
+    const auto start = clock::now();
+
+    std::vector<std::vector<std::uint8_t>> decoded(paths.size());
+    std::vector<char> converted(paths.size(), 0);
+    auto convert = [&](std::size_t begin, std::size_t end) {
+        for(std::size_t i = begin; i < end; i++)
+            converted[i] = loadPcm(paths[i], format.frequency, format.format, format.channels, decoded[i]);
+    };
+    if ( jobs )
+        jobs->parallelFor(0, paths.size(), 1, convert);
+    else
+        convert(0, paths.size());
+
+    std::map<std::string, SoundBank::Sound> sounds;
+    std::uint64_t arenaBytes = 0;
+    for(std::size_t i = 0; i < paths.size(); i++)
+    {
+        if ( !converted[i] )
+            return nullptr;
+        sounds[soundName(paths[i])] = SoundBank::Sound{arenaBytes, decoded[i].size()};
+        arenaBytes = alignUp(arenaBytes + decoded[i].size());
+    }
+
+    auto arena = allocateArena(arenaBytes);
+    for(std::size_t i = 0; i < paths.size(); i++)
+    {
+        const SoundBank::Sound& sound = sounds[soundName(paths[i])];
+        std::memcpy(arena.get() + sound.offset, decoded[i].data(), decoded[i].size());
+        // the padding up to the next sound is never played, but saved banks shouldn't carry heap garbage
+        std::memset(arena.get() + sound.offset + sound.size, 0, alignUp(sound.size) - sound.size);
+    }
+
+    return std::make_shared<SoundBank>(format, std::move(arena), arenaBytes, std::move(sounds), millisecondsSince(start));
+}
+
+std::shared_ptr<SoundBank> openSoundBank(const std::filesystem::path& path)
+{
+    const auto start = clock::now();
+
+    std::ifstream in(path, std::ios::binary);
+    if ( !in )
+    {
+        std::cerr << "Unable to open sound bank " << path << std::endl;
+        return nullptr;
+    }
+
+    BankHeader header{};
+    in.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if ( !in || 0 != std::memcmp(header.magic, bankMagic, sizeof(bankMagic)) || bankVersion != header.version
+        || sizeof(BankHeader) != header.headerSize || sizeof(BankEntry) != header.entrySize )
+    {
+        std::cerr << path << " is not a sound bank of this version" << std::endl;
+        return nullptr;
+    }
+
+    const SoundBank::Format format{static_cast<int>(header.frequency), header.format, header.channels};
+    if ( !(format == deviceSoundFormat()) )
+    {
+        std::cerr << "Sound bank " << path << " doesn't match the mixer format" << std::endl;
+        return nullptr;
+    }
+
+    // the sizes in the header are only trusted once the file is known to hold that much
+    std::error_code error;
+    const std::uint64_t fileSize = std::filesystem::file_size(path, error);
+    const std::uint64_t tableBytes = std::uint64_t(header.soundCount) * sizeof(BankEntry) + header.namesSize;
+    const bool tableFits = !error && fileSize >= sizeof(BankHeader) && fileSize - sizeof(BankHeader) >= tableBytes;
+    const bool arenaFits = !error && header.arenaOffset >= sizeof(BankHeader) + tableBytes
+        && header.arenaOffset <= fileSize && fileSize - header.arenaOffset >= header.arenaSize;
+    if ( !tableFits || !arenaFits )
+    {
+        std::cerr << "Sound bank " << path << " is truncated or corrupt" << std::endl;
+        return nullptr;
+    }
+
+    std::vector<BankEntry> entries(header.soundCount);
+    std::string names(header.namesSize, '\0');
+    in.read(reinterpret_cast<char*>(entries.data()), entries.size() * sizeof(BankEntry));
+    in.read(names.data(), names.size());
+
+    std::map<std::string, SoundBank::Sound> sounds;
+    for(const BankEntry& e : entries)
+    {
+        const bool nameFits = e.nameOffset <= names.size() && names.size() - e.nameOffset >= e.nameSize;
+        const bool dataFits = e.offset % SoundBank::alignment == 0 && e.offset <= header.arenaSize
+            && header.arenaSize - e.offset >= e.size;
+        if ( !in || !nameFits || !dataFits )
+        {
+            std::cerr << "Sound bank " << path << " is truncated or corrupt" << std::endl;
+            return nullptr;
+        }
+        sounds[names.substr(e.nameOffset, e.nameSize)] = SoundBank::Sound{e.offset, e.size};
+    }
+
+    // the arena comes in with a single read, ready to play
+    auto arena = allocateArena(header.arenaSize);
+    in.seekg(static_cast<std::streamoff>(header.arenaOffset));
+    in.read(reinterpret_cast<char*>(arena.get()), static_cast<std::streamsize>(header.arenaSize));
+    if ( !in )
+    {
+        std::cerr << "Sound bank " << path << " is truncated or corrupt" << std::endl;
+        return nullptr;
+    }
+
+    return std::make_shared<SoundBank>(format, std::move(arena), header.arenaSize, std::move(sounds),
+        millisecondsSince(start));
+}
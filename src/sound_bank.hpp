@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <SDL.h>
+#include <SDL_mixer.h>
+
+#include "assets.hpp"
+#include "job_system.hpp"
+
+// Sounds decoded once into the device format and kept back to back in one 64 byte aligned arena.
+// Chunks handed out play the arena in place, so a bank is a single allocation however many sounds it holds,
+// and is saved and read back as one block. Sounds are named by their source path, like AssetCache keys.
+class SoundBank : public std::enable_shared_from_this<SoundBank>
+{
+public:
+    static constexpr std::size_t alignment = 64;
+
+    struct Format
+    {
+        int frequency;
+        Uint16 format;
+        int channels;
+
+        bool operator==(const Format& other) const noexcept
+        {
+            return frequency == other.frequency && format == other.format && channels == other.channels;
+        }
+    };
+
+    struct Sound
+    {
+        std::uint64_t offset;  // into the arena, a multiple of alignment
+        std::uint64_t size;
+    };
+
+    struct ArenaDelete
+    {
+        void operator()(std::uint8_t* arena) const { ::operator delete[](arena, std::align_val_t(alignment)); }
+    };
+    using Arena = std::unique_ptr<std::uint8_t[], ArenaDelete>;
+
+    SoundBank(Format format, Arena&& arena, std::size_t arenaBytes, std::map<std::string, Sound>&& sounds, double loadMs);
+
+    SoundBank(const SoundBank&) = delete;
+    SoundBank& operator=(const SoundBank&) = delete;
+
+    bool contains(const std::filesystem::path& name) const;
+    // Size of the sound's samples, 0 if there is none
+    std::size_t bytes(const std::filesystem::path& name) const;
+
+    // Plays the sound's samples in place, nullptr if the bank hasn't got it. Handles keep the bank alive.
+    ChunkHandle chunk(const std::filesystem::path& name);
+
+    // Writes the format, the sound table and the arena as they are, for openSoundBank
+    bool save(const std::filesystem::path& path) const;
+
+    const Format& format() const noexcept {return m_format;}
+    std::size_t size() const noexcept {return m_sounds.size();}
+    // The arena, padding included
+    std::size_t bytesResident() const noexcept {return m_arenaBytes;}
+    // Decoding and converting, or reading a saved bank
+    double loadMs() const noexcept {return m_loadMs;}
+
+private:
+    Format m_format;
+    Arena m_arena;
+    std::size_t m_arenaBytes;
+    std::map<std::string, Sound> m_sounds;
+    double m_loadMs;
+};
+
+// The format the mixer device is open with, the default one if audio isn't open (e.g. in tools)
+SoundBank::Format deviceSoundFormat();
+
+// Converts every .wav file into format, on the job system if one is given. nullptr if any of them fails.
+std::shared_ptr<SoundBank> loadSoundBank(const std::vector<std::filesystem::path>& paths, JobSystem* jobs = nullptr,
+    const SoundBank::Format& format = deviceSoundFormat());
+
+// nullptr if the file is missing or corrupt, or holds another format than the device plays
+std::shared_ptr<SoundBank> openSoundBank(const std::filesystem::path& path);
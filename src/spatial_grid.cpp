@@ -0,0 +1,32 @@
+#include <algorithm>
+#include <cmath>
+
+#include "spatial_grid.hpp"
+
+void SpatialGrid::build(const float* x, const float* y, std::size_t n, float width, float height)
+{
+    m_columns = std::max(1, static_cast<int>(std::ceil(width / m_cellSize)) + 1);
+    m_rows = std::max(1, static_cast<int>(std::ceil(height / m_cellSize)) + 1);
+    const std::size_t cells = static_cast<std::size_t>(m_columns) * m_rows;
+
+    m_cellStart.assign(cells + 1, 0);
+    m_entries.resize(n);
+    m_cellOf.resize(n);
+
+    const float invCell = 1.0f / m_cellSize;
+    for(std::size_t i = 0; i < n; i++)
+    {
+        const int cx = std::clamp(static_cast<int>(x[i] * invCell), 0, m_columns - 1);
+        const int cy = std::clamp(static_cast<int>(y[i] * invCell), 0, m_rows - 1);
+        const std::uint32_t c = cy * m_columns + cx;
+        m_cellOf[i] = c;
+        m_cellStart[c + 1]++;
+    }
+
+    for(std::size_t c = 0; c < cells; c++)
+        m_cellStart[c + 1] += m_cellStart[c];
+
+    m_cursor.assign(m_cellStart.begin(), m_cellStart.end() - 1);
+    for(std::size_t i = 0; i < n; i++)
+        m_entries[m_cursor[m_cellOf[i]]++] = static_cast<std::uint32_t>(i);
+}
@@ -0,0 +1,143 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "job_system.hpp"
+
+// Uniform grid broadphase. Rebuilt from scratch every step with a counting sort,
+// so building is O(N) and buffers are reused between steps.
+// Objects whose bounding circles are smaller than the cell size only ever need
+// to be tested against their own cell and the 8 neighbours.
+class SpatialGrid
+{
+public:
+    explicit SpatialGrid(float cellSize): m_cellSize(cellSize) {}
+
+    float cellSize() const noexcept {return m_cellSize;}
+    void setCellSize(float cellSize) noexcept {m_cellSize = cellSize;}
+
+    void build(const float* x, const float* y, std::size_t n, float width, float height);
+
+    // Calls f(i, j) once for every pair of objects in the same or adjacent cells.
+    // f returns true when it did something with the pair (e.g. resolved a collision).
+    template<typename F>
+    void forEachPair(F&& f);
+
+    // Same as forEachPair, but rows of cells are spread over the job system.
+    // Rows are processed in three waves (row % 3) so two jobs never touch the
+    // same object: f may safely modify the objects it is given.
+    template<typename F>
+    void forEachPairParallel(JobSystem& jobs, F&& f);
+
+    int columns() const noexcept {return m_columns;}
+    int rows() const noexcept {return m_rows;}
+
+    std::uint64_t pairsTested() const noexcept {return m_pairsTested;}
+    std::uint64_t pairsResolved() const noexcept {return m_pairsResolved;}
+    void resetCounters() noexcept { m_pairsTested = 0; m_pairsResolved = 0; }
+
+private:
+    struct Counters
+    {
+        std::uint64_t tested{0};
+        std::uint64_t resolved{0};
+    };
+
+    template<typename F>
+    void testCells(int a, int b, F& f, Counters& counters) const;
+
+    template<typename F>
+    void testRow(int cy, F& f, Counters& counters) const;
+
+    float m_cellSize{1};
+    int m_columns{0};
+    int m_rows{0};
+
+    // objects of cell c are m_entries[m_cellStart[c] .. m_cellStart[c+1])
+    std::vector<std::uint32_t> m_cellStart;
+    std::vector<std::uint32_t> m_entries;
+    std::vector<std::uint32_t> m_cellOf;
+    std::vector<std::uint32_t> m_cursor;
+
+    std::uint64_t m_pairsTested{0};
+    std::uint64_t m_pairsResolved{0};
+};
+
+template<typename F>
+void SpatialGrid::testCells(int a, int b, F& f, Counters& counters) const
+{
+    const std::uint32_t aBegin = m_cellStart[a], aEnd = m_cellStart[a + 1];
+    const std::uint32_t bBegin = m_cellStart[b], bEnd = m_cellStart[b + 1];
+
+    for(std::uint32_t i = aBegin; i < aEnd; i++)
+        for(std::uint32_t j = (a == b ? i + 1 : bBegin); j < bEnd; j++)
+        {
+            counters.tested++;
+            if ( f(m_entries[i], m_entries[j]) )
+                counters.resolved++;
+        }
+}
+
+template<typename F>
+void SpatialGrid::testRow(int cy, F& f, Counters& counters) const
+{
+    // Visit only half of the neighbourhood so every pair of cells is seen once
+    for(int cx = 0; cx < m_columns; cx++)
+    {
+        const int c = cy * m_columns + cx;
+        if ( m_cellStart[c] == m_cellStart[c + 1] )
+            continue;
+
+        testCells(c, c, f, counters);
+        if ( cx + 1 < m_columns )
+            testCells(c, c + 1, f, counters);
+        if ( cy + 1 < m_rows )
+        {
+            if ( cx > 0 )
+                testCells(c, c + m_columns - 1, f, counters);
+            testCells(c, c + m_columns, f, counters);
+            if ( cx + 1 < m_columns )
+                testCells(c, c + m_columns + 1, f, counters);
+        }
+    }
+}
+
+template<typename F>
+void SpatialGrid::forEachPair(F&& f)
+{
+    // same row order as forEachPairParallel, so both give identical results
+    Counters counters;
+    for(int wave = 0; wave < 3; wave++)
+        for(int cy = wave; cy < m_rows; cy += 3)
+            testRow(cy, f, counters);
+
+    m_pairsTested += counters.tested;
+    m_pairsResolved += counters.resolved;
+}
+
+template<typename F>
+void SpatialGrid::forEachPairParallel(JobSystem& jobs, F&& f)
+{
+    // a row touches itself and the next one, so rows 3 apart never share objects
+    std::vector<Counters> counters(m_rows);
+    for(int wave = 0; wave < 3; wave++)
+    {
+        const std::size_t rowsInWave = (m_rows - wave + 2) / 3;
+        jobs.parallelFor(0, rowsInWave, 1, [&](std::size_t begin, std::size_t end)
+        {
+            for(std::size_t k = begin; k < end; k++)
+            {
+                const int cy = wave + 3 * static_cast<int>(k);
+                testRow(cy, f, counters[cy]);
+            }
+        });
+    }
+
+    for(const Counters& c : counters)
+    {
+        m_pairsTested += c.tested;
+        m_pairsResolved += c.resolved;
+    }
+}
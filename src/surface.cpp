@@ -6,6 +6,7 @@
 #include <SDL_image.h>
 
 #include "surface.hpp"
+#include "pixel_convert.hpp"
 
 std::unique_ptr<SDL_Surface> loadSurface(const std::filesystem::path& path, const SDL_PixelFormat* pixelFormat)
 {
@@ -16,6 +17,13 @@ std::unique_ptr<SDL_Surface> loadSurface(const std::filesystem::path& path, cons
       return nullptr;
   }
 
+  if ( SDL_PIXELFORMAT_ARGB8888 == pixelFormat->format )
+  {
+      auto converted = convertToArgb8888(surface);
+      SDL_FreeSurface(surface);
+      return converted;
+  }
+
   SDL_Surface* optimizedSurface = SDL_ConvertSurface( surface, pixelFormat,  0);
   if (NULL == optimizedSurface)
   {
@@ -26,3 +34,18 @@ std::unique_ptr<SDL_Surface> loadSurface(const std::filesystem::path& path, cons
   SDL_FreeSurface(surface);
   return std::unique_ptr<SDL_Surface>(optimizedSurface);
 }
+
+std::unique_ptr<SDL_Surface> loadImage(const std::filesystem::path& path)
+{
+  SDL_Surface* surface = IMG_Load( path.c_str() );
+  if (NULL == surface )
+  {
+      std::cerr << "Unable to load surface from " << path << "! IMG_error: " << IMG_GetError() << std::endl;
+      return nullptr;
+  }
+
+  SDL_SetColorKey( surface, SDL_TRUE, SDL_MapRGB( surface->format, 0xFF, 0xFF, 0xFF ) );
+  auto converted = convertToArgb8888(surface);
+  SDL_FreeSurface(surface);
+  return converted;
+}
@@ -1,3 +1,5 @@
+#pragma once
+
 #include <iostream>
 #include <memory>
 #include <filesystem>
@@ -15,3 +17,6 @@ public:
 };
 
 std::unique_ptr<SDL_Surface> loadSurface(const std::filesystem::path& path, const SDL_PixelFormat* pixelFormat);
+
+// Converts to ARGB8888 with white made transparent, like loadTexture
+std::unique_ptr<SDL_Surface> loadImage(const std::filesystem::path& path);
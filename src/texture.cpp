@@ -10,6 +10,8 @@
 
 #include "context.hpp"
 #include "texture.hpp"
+#include "surface.hpp"
+#include "profiler.hpp"
 
 void Texture::renderAt(Context& ctx, int x, int y)
 {
@@ -17,34 +19,34 @@ void Texture::renderAt(Context& ctx, int x, int y)
     SDL_RenderCopy( ctx.renderer(), texture(), NULL, &rect);
 }
 
+std::size_t textureBytes(SDL_Texture* texture)
+{
+    Uint32 format = SDL_PIXELFORMAT_ARGB8888;
+    int w = 0, h = 0;
+    SDL_QueryTexture( texture, &format, NULL, &w, &h );
+    return static_cast<std::size_t>(w) * h * SDL_BYTESPERPIXEL(format);
+}
+
 std::optional<Texture> loadTexture(const std::filesystem::path& path, Context& ctx)
 {
-  SDL_Surface* surface = IMG_Load( path.c_str() );
-  if (NULL == surface )
-  {
-      std::cerr << "Unable to load surface from " << path << "! IMG_error: " << IMG_GetError() << std::endl;
+  PROFILE_ZONE("loadTexture");
+  auto surface = loadImage(path);
+  if ( !surface )
       return std::nullopt;
-  }
 
-  SDL_SetColorKey( surface, SDL_TRUE, SDL_MapRGB( surface->format, 0xFF, 0xFF, 0xFF ) );
-
-  SDL_Texture* texture = SDL_CreateTextureFromSurface( ctx.renderer(), surface );
+  SDL_Texture* texture = SDL_CreateTextureFromSurface( ctx.renderer(), surface.get() );
   if (NULL == texture )
   {
       std::cerr << "Unable to create texture from " << path << "! SDL_error: " << SDL_GetError() << std::endl;
       return std::nullopt;
   }
 
-  Texture r(texture, surface->w, surface->h);
-
-  SDL_FreeSurface( surface );
-
-  return r;
+  return Texture(texture, surface->w, surface->h);
 }
 
-std::optional<Texture> textureFromText(Context& ctx, const std::string& text,  const std::unique_ptr<TTF_Font>& font, const SDL_Color& color)
+std::optional<Texture> textureFromText(Context& ctx, const std::string& text, TTF_Font* font, const SDL_Color& color)
 {
-  SDL_Surface* surface = TTF_RenderText_Solid( font.get(), text.c_str(), color );
+  SDL_Surface* surface = TTF_RenderText_Solid( font, text.c_str(), color );
   if (NULL == surface )
   {
       std::cerr << "Unable to render text from " << text << "! SDL_ttf Error: " << TTF_GetError() << std::endl;
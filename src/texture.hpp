@@ -1,3 +1,5 @@
+#pragma once
+
 #include <iostream>
 #include <memory>
 #include <filesystem>
@@ -55,4 +57,7 @@ protected:
 
 std::optional<Texture> loadTexture(const std::filesystem::path& path, Context& ctx);
 
-std::optional<Texture> textureFromText(Context& ctx, const std::string& text,  const std::unique_ptr<TTF_Font>& font, const SDL_Color& color);
+// Memory the texture's pixels take, in its own format
+std::size_t textureBytes(SDL_Texture* texture);
+
+std::optional<Texture> textureFromText(Context& ctx, const std::string& text, TTF_Font* font, const SDL_Color& color);
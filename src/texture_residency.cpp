@@ -0,0 +1,126 @@
+#include <iostream>
+#include <chrono>
+#include <algorithm>
+
+#include "texture_residency.hpp"
+
+void TextureResidency::setBudget(std::size_t bytes)
+{
+    m_budget = bytes;
+    makeRoom(0);
+}
+
+TextureResidency::Id TextureResidency::add(const std::filesystem::path& path)
+{
+    m_entries.push_back(Entry{});
+    m_entries.back().path = path;
+    return static_cast<Id>(m_entries.size() - 1);
+}
+
+TextureResidency::Id TextureResidency::add(ImageHandle pixels)
+{
+    m_entries.push_back(Entry{});
+    Entry& entry = m_entries.back();
+    entry.w = pixels->w;
+    entry.h = pixels->h;
+    entry.pixels = std::move(pixels);
+    return static_cast<Id>(m_entries.size() - 1);
+}
+
+SDL_Texture* TextureResidency::acquire(Context& ctx, Id id)
+{
+    Entry& entry = m_entries.at(id);
+    if ( entry.texture )
+    {
+        m_stats.hits++;
+        m_recent.splice(m_recent.begin(), m_recent, entry.recent);
+    }
+    else
+    {
+        m_stats.misses++;
+        if ( !upload(ctx, id) )
+        {
+            m_stats.failures++;
+            return nullptr;
+        }
+    }
+    entry.lastFrame = m_frame;
+    return entry.texture.get();
+}
+
+bool TextureResidency::render(Context& ctx, Id id, const SDL_Rect* dst, const SDL_Rect* clip)
+{
+    SDL_Texture* texture = acquire(ctx, id);
+    if ( NULL == texture )
+        return false;
+    SDL_RenderCopy( ctx.renderer(), texture, clip, dst );
+    return true;
+}
+
+bool TextureResidency::upload(Context& ctx, Id id)
+{
+    Entry& entry = m_entries[id];
+    const auto start = std::chrono::steady_clock::now();
+    // in use from now on, making room must not pick the texture itself
+    entry.lastFrame = m_frame;
+
+    // a known size makes room before the upload, so the budget isn't overrun even briefly
+    if ( entry.w > 0 )
+        makeRoom(static_cast<std::size_t>(entry.w) * entry.h * 4);
+
+    std::unique_ptr<SDL_Surface> loaded;
+    SDL_Surface* surface = entry.pixels.get();
+    if ( !surface )
+    {
+        loaded = loadImage(entry.path);
+        surface = loaded.get();
+    }
+    if ( !surface )
+        return false;
+
+    SDL_Texture* texture = SDL_CreateTextureFromSurface( ctx.renderer(), surface );
+    if ( NULL == texture )
+    {
+        std::cerr << "Unable to upload texture " << entry.path << "! SDL_error: " << SDL_GetError() << std::endl;
+        return false;
+    }
+
+    entry.texture.reset(texture);
+    entry.w = surface->w;
+    entry.h = surface->h;
+    entry.bytes = textureBytes(texture);
+    m_recent.push_front(id);
+    entry.recent = m_recent.begin();
+    m_bytesResident += entry.bytes;
+    m_stats.peakBytes = std::max(m_stats.peakBytes, m_bytesResident);
+    makeRoom(0);
+
+    const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    m_stats.uploadMs += ms;
+    m_stats.worstUploadMs = std::max(m_stats.worstUploadMs, ms);
+    return true;
+}
+
+void TextureResidency::makeRoom(std::size_t needed)
+{
+    while ( !m_recent.empty() && m_bytesResident + needed > m_budget )
+    {
+        const Id victim = m_recent.back();
+        // the list is in recency order, if the last one is in use this frame so are all others
+        if ( m_entries[victim].lastFrame == m_frame )
+            break;
+        evict(victim);
+        m_stats.evictions++;
+    }
+}
+
+void TextureResidency::evict(Id id)
+{
+    Entry& entry = m_entries.at(id);
+    if ( !entry.texture )
+        return;
+    entry.texture.reset();
+    m_recent.erase(entry.recent);
+    m_bytesResident -= entry.bytes;
+    entry.bytes = 0;
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <list>
+#include <memory>
+#include <vector>
+
+#include <SDL.h>
+
+#include "assets.hpp"
+#include "context.hpp"
+#include "texture.hpp"
+
+// Keeps the textures it manages within a byte budget by evicting the least recently rendered ones.
+// Every texture remembers where its pixels come from, a surface kept in memory or an image file,
+// and is uploaded again the next time it is drawn after an eviction.
+// Textures drawn in the current frame are never evicted; if they alone exceed the budget it is overrun for that frame.
+//
+// It is meant for large sprite sets, sdlbench --textures measures it. sdlplay and sdldull don't use it: their images
+// are packed into one or two atlas pages (see TextureAtlas) that every frame draws from, so there is nothing to evict.
+class TextureResidency
+{
+public:
+    using Id = std::uint32_t;
+
+    struct Stats
+    {
+        std::size_t hits{0};        // acquires that found the texture resident
+        std::size_t misses{0};      // acquires that had to upload it first
+        std::size_t evictions{0};
+        std::size_t failures{0};    // uploads that failed, e.g. a file gone missing
+        double uploadMs{0};         // time acquire() stalled the frame for uploads
+        double worstUploadMs{0};
+        std::size_t peakBytes{0};
+
+        double hitRatio() const noexcept {return hits + misses ? double(hits) / (hits + misses) : 1.0;}
+    };
+
+    explicit TextureResidency(std::size_t budgetBytes): m_budget(budgetBytes) {}
+
+    TextureResidency(const TextureResidency&) = delete;
+    TextureResidency& operator=(const TextureResidency&) = delete;
+
+    // Lowering the budget evicts right away, down to what the current frame uses
+    void setBudget(std::size_t bytes);
+    std::size_t budget() const noexcept {return m_budget;}
+
+    // Decoded with loadImage on every upload, nothing stays in memory while the texture is evicted
+    Id add(const std::filesystem::path& path);
+    // The surface is kept for re-uploads, e.g. a cached image or one that has no file
+    Id add(ImageHandle pixels);
+
+    // Starts a new frame: textures acquired before it may be evicted again
+    void beginFrame() noexcept {m_frame++;}
+
+    // Texture for drawing, uploaded first if it isn't resident. nullptr if that fails.
+    // The pointer stays valid until the next beginFrame().
+    SDL_Texture* acquire(Context& ctx, Id id);
+
+    // Same as TextureRegion::render for the whole texture; false if it couldn't be uploaded
+    bool render(Context& ctx, Id id, const SDL_Rect* dst, const SDL_Rect* clip = nullptr);
+
+    // 0 until the texture has been uploaded once if it comes from a file
+    int width(Id id) const {return m_entries.at(id).w;}
+    int height(Id id) const {return m_entries.at(id).h;}
+
+    bool resident(Id id) const {return nullptr != m_entries.at(id).texture;}
+    void evict(Id id);
+
+    std::size_t size() const noexcept {return m_entries.size();}
+    std::size_t residentCount() const noexcept {return m_recent.size();}
+    std::size_t bytesResident() const noexcept {return m_bytesResident;}
+
+    const Stats& stats() const noexcept {return m_stats;}
+    void resetStats() noexcept {m_stats = Stats{};}
+
+private:
+    struct Entry
+    {
+        std::filesystem::path path;
+        ImageHandle pixels;
+        std::unique_ptr<SDL_Texture> texture;
+        int w{0};
+        int h{0};
+        std::size_t bytes{0};
+        std::uint64_t lastFrame{0};
+        std::list<Id>::iterator recent;
+    };
+
+    bool upload(Context& ctx, Id id);
+    // Evicts from the least recent end until needed more bytes fit, leaving this frame's textures alone
+    void makeRoom(std::size_t needed);
+
+    std::size_t m_budget;
+    std::vector<Entry> m_entries;
+    std::list<Id> m_recent;  // resident textures, most recently rendered first
+    std::size_t m_bytesResident{0};
+    std::uint64_t m_frame{1};
+    Stats m_stats;
+};